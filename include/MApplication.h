@@ -1,12 +1,27 @@
 #pragma once
 
 #include "MWindow.h"
+#include "MFrameStats.h"
+#include "MFrustumCuller.h"
+#include "MLoopScheduler.h"
+#include "MSpscQueue.h"
+#include "VulkanCullingPass.h"
+#include "VulkanDescriptorAllocator.h"
 #include "VulkanDevice.h"
 #include "VulkanPipeline.h"
+#include "VulkanPipelineCompiler.h"
+#include "VulkanPipelineProvider.h"
+#include "VulkanRenderQueue.h"
 #include "VulkanSwapchain.h"
 #include "VulkanModel.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 namespace moo {
 
@@ -14,17 +29,81 @@ class MApplication {
 public:
     static constexpr int WIDTH = 1024;
     static constexpr int HEIGHT = 768;
+    static constexpr const char* FRAME_STATS_FILE = "frame_stats.csv";
+    static constexpr const char* VERT_SHADER_FILE = "./../shaders/shader.vert.spv";
+    static constexpr const char* FRAG_SHADER_FILE = "./../shaders/shader.frag.spv";
+    static constexpr int IDLE_WAIT_TIMEOUT_MS = 250;     // upper bound of a blocking wait when there is nothing to draw
+    static constexpr uint32_t REDRAW_INTERVAL_MS = 0;    // animation tick, the scene is static for now
+    static constexpr size_t EVENT_QUEUE_SIZE = 256;      // events in flight between the event and render threads
+    static constexpr double UPDATE_RATE = 60.0;          // fixed simulation ticks per second
+    static constexpr double RENDER_CAP = 0.0;            // frames per second upper bound, 0 = vsync only
+    static constexpr float SPIN_SPEED = 0.0f;            // model1 rotation in radians per simulated second, static for now
+    static constexpr bool EXTENDED_DYNAMIC_STATE = true; // raster/depth state set while recording, when the GPU has Vulkan 1.3
+    static constexpr bool GPU_DRIVEN_DRAWS = true;       // culled and drawn by the GPU where VulkanCullingPass::isSupported
+    static constexpr uint32_t MAX_SCENE_OBJECTS = 1 << 18;
+    static constexpr float LOD_PIXEL_ERROR = 1.0f;       // coarsest LOD whose simplification stays under this on screen
+    static constexpr bool BINDLESS = false;              // one resource set bound per frame, materials are push constant indices
 
 private:
     MWindow m_window{"I'm Mopugno", WIDTH, HEIGHT};
-    VulkanDevice m_device{m_window};
+    VulkanDevice m_device{m_window, BINDLESS};
+    // declared before the compiler and the pipelines: outlives both
+    VulkanPipelineRegistry m_pipelineRegistry{m_device.getDevice(), m_device.getPipelineCache().getCache()};
+    VulkanPipelineCompiler m_pipelineCompiler{m_device};
+    VulkanPipelineProvider m_pipelines{m_device, m_pipelineCompiler};
+    MFrameStats m_frameStats{};
     std::unique_ptr<VulkanSwapchain> m_swapchain;
-    std::unique_ptr<VulkanPipeline> m_pipeline;
-    VkPipelineLayout m_pipelineLayout;
+    VulkanPipelineProvider::Handle m_pipeline = VulkanPipelineProvider::INVALID_HANDLE;
+    VkFormat m_pipelineFormat = VK_FORMAT_UNDEFINED;    // color format m_pipeline was built for
+    VkPipelineLayout m_pipelineLayout;                  // owned by the device layout cache
     std::vector<VkCommandBuffer> m_commandBuffers;
+    VulkanCommandEncoder m_encoder;                     // records the frame, skips redundant binds
+    std::unique_ptr<VulkanDescriptorAllocator> m_descriptors;   // transient sets, one slot per command buffer
+    std::unique_ptr<VulkanBindlessTable> m_bindless;    // BINDLESS and supported: set 0 of m_pipelineLayout
+    bool m_extendedDynamicState = false;
+    uint32_t m_pipelineDynamicStates = 0;               // VulkanCommandEncoder::DynamicStates of m_pipeline
+
+    // gpu frame time: begin/end timestamp pair per command buffer
+    VkQueryPool m_timestampPool = VK_NULL_HANDLE;
+    std::vector<bool> m_timestampsWritten;
     
     std::unique_ptr<VulkanModel> model1;
 
+    // GPU_DRIVEN_DRAWS: every object draws a range of model1, one culling slot per command buffer
+    std::vector<VulkanCullingPass::Object> m_sceneObjects;
+    std::unique_ptr<VulkanCullingPass> m_cullingPass;
+
+    // without the culling pass: bounding volumes culled on the CPU, one per drawn object
+    MFrustumCuller m_culler;
+    std::vector<uint32_t> m_visible;
+    std::vector<uint32_t> m_objectLods;                 // per culler object, last frame's LOD
+
+    // draws of the frame being recorded, sorted by state before submission
+    VulkanRenderQueue m_renderQueue;
+
+    // everything the fixed step advances; rendering blends the last two states
+    struct SimulationState {
+        double time = 0.0;
+        float angle = 0.0f;     // model1 around z, radians
+    };
+
+    MLoopScheduler m_scheduler{UPDATE_RATE, RENDER_CAP};
+    SimulationState m_previousState{};
+    SimulationState m_currentState{};
+    SimulationState m_renderState{};                    // blended for the frame being drawn: the pushed transform
+
+    // the main thread only pumps SDL events, drawing happens on m_renderThread:
+    // a slow present or a swapchain recreation no longer stalls input and window dragging
+    std::thread m_renderThread;
+    MSpscQueue<SDL_Event, EVENT_QUEUE_SIZE> m_eventQueue;
+    std::atomic<uint64_t> m_droppedEvents{0};
+    std::exception_ptr m_renderError;
+    bool m_swapchainOutdated = false;                   // render thread: resized, recreated before the next frame
+
+    std::mutex m_renderWakeMutex;
+    std::condition_variable m_renderWake;
+    bool m_renderWakePending = false;
+
 public:
     MApplication();
     ~MApplication();
@@ -34,11 +113,30 @@ public:
 
     void run();
 
+    // loop settings, to be changed before run()
+    inline void setUpdateRate(double hz) { m_scheduler.setUpdateRate(hz); }
+    inline void setRenderCap(double fps) { m_scheduler.setRenderCap(fps); }
+
 private:
+    void renderLoop();
+    // event thread side: forwards the event and wakes up the render thread
+    void forwardEvent(const SDL_Event& event);
+    void wakeRenderThread();
+    void waitForRenderWake(std::chrono::steady_clock::duration timeout);
+    void handleRenderEvent(const SDL_Event& event);
+    void update(double dt);
+    void interpolateState(float alpha);
+    // no step would move anything: an idle loop doesn't wake up for them
+    inline bool isSimulationStatic() const { return SPIN_SPEED == 0.0f; }
+
     void createPipelineLayout();
     void createPipeline();
     void createCommandBuffers();
     void freeCommandBuffers();
+    void createTimestampQueryPool();
+    void destroyTimestampQueryPool();
+    void createCullingPass();
+    void collectGpuFrameTime(int imgIndex);
     void drawFrame();
     void reCreateSwapchain();
     void recordCommandBuffer(int imgIndex);
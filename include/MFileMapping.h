@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace moo {
+
+// Read-only memory mapping of a whole file: the OS pages the content in on demand,
+// no copy into a heap buffer. Move-only, unmapped on destruction.
+class MFileMapping {
+public:
+    MFileMapping() = default;
+    explicit MFileMapping(const std::string& filepath);
+    ~MFileMapping();
+
+    MFileMapping(const MFileMapping&) = delete;
+    MFileMapping& operator=(const MFileMapping&) = delete;
+    MFileMapping(MFileMapping&& other) noexcept;
+    MFileMapping& operator=(MFileMapping&& other) noexcept;
+
+    inline const void* data() const { return m_data; }
+    inline size_t size() const { return m_size; }
+    inline bool isMapped() const { return m_data != nullptr; }
+
+private:
+    const void* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;     // HANDLE
+    void* m_mapping = nullptr;  // HANDLE
+#endif
+
+    void unmap();
+};
+
+}   // namespace moo
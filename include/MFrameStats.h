@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace moo {
+
+// Frame timing collector: every metric keeps a sliding window of samples
+// mirrored into a fixed-width histogram, so percentiles are cheap to query.
+// Averages hide stutters, p99 and max don't.
+class MFrameStats {
+public:
+    enum class Metric : uint32_t {
+        CpuFrame = 0,   // wall time of drawFrame on the CPU
+        GpuFrame,       // timestamp delta of the frame command buffer
+        WaitFence,      // blocked in vkWaitForFences
+        Acquire,        // blocked in vkAcquireNextImageKHR
+        Present,        // blocked in vkQueuePresentKHR
+        Count
+    };
+
+    struct Percentiles {
+        float p50 = 0.0f;
+        float p95 = 0.0f;
+        float p99 = 0.0f;
+        float max = 0.0f;
+        uint32_t samples = 0;
+    };
+
+    // adds the time spent in the enclosing scope to the current frame,
+    // a null stats pointer turns it into a no-op
+    class ScopedTimer {
+    public:
+        ScopedTimer(MFrameStats* stats, Metric metric);
+        ~ScopedTimer();
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        MFrameStats* m_stats;
+        Metric m_metric;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    static constexpr uint32_t DEFAULT_WINDOW_SIZE = 600;   // ~10 seconds at 60 fps
+    static constexpr uint32_t BUCKET_COUNT = 2000;         // last bucket collects everything above the range
+    static constexpr float BUCKET_WIDTH_MS = 0.05f;        // 0 - 100 ms at 50 us resolution
+
+    explicit MFrameStats(uint32_t windowSize = DEFAULT_WINDOW_SIZE);
+    ~MFrameStats();
+
+    MFrameStats(const MFrameStats&) = delete;
+    MFrameStats& operator=(const MFrameStats&) = delete;
+
+    // frame bracket: CpuFrame and the blocking metrics are committed once per frame
+    void beginFrame();
+    // returns true when a periodic report was produced during this call
+    bool endFrame();
+
+    // accumulate into the current frame (several fence waits in one frame add up)
+    void add(Metric metric, float milliseconds);
+    // push a sample straight into the window (GPU results arrive frames later)
+    void record(Metric metric, float milliseconds);
+
+    Percentiles percentiles(Metric metric) const;
+
+    // CSV export, an empty path disables it. False when the file can't be opened: stats are
+    // still collected, just not exported
+    bool setReportFile(const std::string& filepath);
+    inline void setReportInterval(double seconds) { m_reportInterval = seconds; }
+
+    // one line "cpu p50/p99 | gpu p50/p99" summary of the last report, used as overlay text
+    inline const std::string& getSummary() const { return m_summary; }
+
+    static const char* metricName(Metric metric);
+
+private:
+    static constexpr size_t METRIC_COUNT = static_cast<size_t>(Metric::Count);
+
+    struct Window {
+        std::vector<float> samples;     // ring buffer, oldest sample gets evicted
+        std::vector<uint32_t> buckets;  // histogram of the samples currently in the ring
+        uint32_t head = 0;
+        uint32_t count = 0;
+    };
+
+    uint32_t m_windowSize;
+    std::array<Window, METRIC_COUNT> m_windows;
+    std::array<float, METRIC_COUNT> m_frameAccum {};
+    std::array<bool, METRIC_COUNT> m_frameTouched {};
+
+    std::chrono::steady_clock::time_point m_startTime;
+    std::chrono::steady_clock::time_point m_frameStart;
+    std::chrono::steady_clock::time_point m_lastReport;
+    double m_reportInterval = 5.0;
+
+    std::ofstream m_reportFile;
+    std::string m_summary;
+
+    static uint32_t bucketIndex(float milliseconds);
+    void report();
+};
+
+}   // namespace moo
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "MThreadPool.h"
+
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace moo {
+
+// CPU visibility: bounding volumes against the six frustum planes, for when the GPU doesn't cull
+// (no VulkanCullingPass: software rasterizers such as lavapipe, compute-less paths).
+// Volumes are stored structure-of-arrays, one stream per component, and tested 8 at a time with
+// AVX2, 4 with SSE, one by one otherwise (picked at runtime from the CPU). A sphere is a center and
+// a radius, a box a center and half extents: both go through the same test, the box's extents
+// projected on each plane normal. Large scenes are split in batches run on an MThreadPool.
+class MFrustumCuller {
+public:
+    enum class Isa : uint32_t {
+        Scalar = 0,
+        Sse,
+        Avx2
+    };
+
+    static constexpr uint32_t BATCH_SIZE = 4096;    // objects per job, multiple of every SIMD width
+
+    // plane: xyz normal pointing inside, w distance; normalized (VulkanCullingPass::extractFrustumPlanes)
+    using Planes = std::array<glm::vec4, 6>;
+
+    MFrustumCuller();
+
+    // index of the volume, dense from 0 in insertion order
+    uint32_t addSphere(const glm::vec4 &sphere);                    // xyz center, w radius
+    uint32_t addBox(const glm::vec3 &min, const glm::vec3 &max);
+    void setSphere(uint32_t index, const glm::vec4 &sphere);
+    void setBox(uint32_t index, const glm::vec3 &min, const glm::vec3 &max);
+    void clear();
+    void reserve(size_t count);
+
+    // visible: indices of the volumes at least partly inside, ascending. pool: helps with
+    // scenes larger than a batch, the calling thread culls as well and never waits for a busy pool
+    uint32_t cull(const Planes &planes, std::vector<uint32_t> &visible, MThreadPool *pool = nullptr);
+
+    inline uint32_t size() const { return static_cast<uint32_t>(m_radius.size()); }
+    inline Isa getIsa() const { return m_isa; }
+    // Scalar always works; a wider set than the CPU has falls back to the detected one
+    void setIsa(Isa isa);
+
+    static Isa detectIsa();
+
+private:
+    // structure of arrays: a SIMD load takes the same component of consecutive volumes
+    std::vector<float> m_centerX;
+    std::vector<float> m_centerY;
+    std::vector<float> m_centerZ;
+    std::vector<float> m_extentX;       // box half extents, 0 for spheres
+    std::vector<float> m_extentY;
+    std::vector<float> m_extentZ;
+    std::vector<float> m_radius;        // sphere radius, 0 for boxes
+
+    Isa m_isa;
+    std::vector<uint32_t> m_scratch;    // per batch output, BATCH_SIZE apart
+};
+
+}   // namespace moo
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// compile-time floor: calls below it are type-checked but never executed
+// 0 trace, 1 debug, 2 info, 3 warning, 4 error, 5 off
+#ifndef MOO_LOG_MIN_LEVEL
+#   ifdef NDEBUG
+#       define MOO_LOG_MIN_LEVEL 2
+#   else
+#       define MOO_LOG_MIN_LEVEL 1
+#   endif
+#endif
+
+namespace moo {
+
+enum class LogLevel : uint8_t {
+    Trace = 0,
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Off
+};
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4324) // padding introduced by alignas is the point
+#endif
+
+// Asynchronous logger: producers format into a slot of a bounded lock-free MPSC ring
+// and return, a background thread does the terminal I/O.
+// A full ring drops the message (counted) instead of blocking the caller.
+class MLogger {
+public:
+    static constexpr uint32_t QUEUE_CAPACITY = 1024; // must be a power of two
+    static constexpr uint32_t MESSAGE_SIZE = 1000; // validation layer messages easily exceed a few hundred chars
+
+    static MLogger& instance();
+
+    ~MLogger();
+
+    MLogger(const MLogger&) = delete;
+    MLogger& operator=(const MLogger&) = delete;
+
+    void log(LogLevel level, const char* format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+        __attribute__((format(printf, 3, 4)))
+#endif
+        ;
+
+    // blocks until everything logged before the call has been written
+    void flush();
+
+    // runs task on the writer thread every interval, an empty task clears it.
+    // Returns once a task already running has finished, so its captures can be released afterwards.
+    void setPeriodicTask(std::function<void()> task, std::chrono::milliseconds interval);
+
+    inline uint64_t droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    static const char* levelName(LogLevel level);
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        uint64_t timestamp;     // nanoseconds since logger start
+        LogLevel level;
+        char text[MESSAGE_SIZE];
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+
+    alignas(64) std::atomic<uint64_t> m_enqueuePos {0};
+    alignas(64) std::atomic<uint64_t> m_dequeuePos {0};
+    alignas(64) std::atomic<uint64_t> m_dropped {0};
+    std::atomic<bool> m_consumerSleeping {false};
+    std::atomic<bool> m_running {true};
+
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_drained;
+
+    std::mutex m_taskMutex;
+    std::function<void()> m_task;
+    std::chrono::milliseconds m_taskInterval {0};
+    std::chrono::steady_clock::time_point m_nextTask;
+
+    int64_t m_startTime;
+    std::thread m_writer;
+
+    MLogger();
+
+    void writerLoop();
+    // writes every published slot, returns the number of messages written
+    uint32_t drain();
+    void runPeriodicTask();
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}   // namespace moo
+
+#define MOO_LOG(level, ...)                                                     \
+    do                                                                          \
+    {                                                                           \
+        if constexpr (static_cast<int>(level) >= MOO_LOG_MIN_LEVEL)             \
+        {                                                                       \
+            ::moo::MLogger::instance().log(level, __VA_ARGS__);                 \
+        }                                                                       \
+    } while(0)                                                                  \
+
+#define MOO_LOG_TRACE(...)   MOO_LOG(::moo::LogLevel::Trace, __VA_ARGS__)
+#define MOO_LOG_DEBUG(...)   MOO_LOG(::moo::LogLevel::Debug, __VA_ARGS__)
+#define MOO_LOG_INFO(...)    MOO_LOG(::moo::LogLevel::Info, __VA_ARGS__)
+#define MOO_LOG_WARNING(...) MOO_LOG(::moo::LogLevel::Warning, __VA_ARGS__)
+#define MOO_LOG_ERROR(...)   MOO_LOG(::moo::LogLevel::Error, __VA_ARGS__)
\ No newline at end of file
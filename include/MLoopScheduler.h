@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace moo {
+
+// Fixed timestep scheduler: simulation advances in constant steps drained from a time
+// accumulator, rendering runs at its own (optionally capped) rate and blends the last
+// two simulation states with alpha. Heavy render load costs frames, never simulation speed.
+class MLoopScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Tick {
+        uint32_t updates = 0;       // fixed steps to run before rendering, each one getStepSeconds() long
+        bool render = false;        // the render cap allows a frame now
+        float alpha = 0.0f;         // [0, 1) position between the previous and the current simulation state
+    };
+
+    static constexpr double DEFAULT_UPDATE_RATE = 60.0;
+    static constexpr uint32_t DEFAULT_MAX_UPDATES = 5;     // catch-up limit per frame, avoids the spiral of death
+
+    MLoopScheduler(double updateRate = DEFAULT_UPDATE_RATE, double renderCap = 0.0);
+
+    // simulation ticks per second
+    void setUpdateRate(double hz);
+    // frames per second upper bound, 0 = uncapped (vsync still applies)
+    void setRenderCap(double fps);
+    void setMaxUpdatesPerFrame(uint32_t updates);
+
+    inline double getUpdateRate() const { return m_updateRate; }
+    inline double getRenderCap() const { return m_renderCap; }
+    inline double getStepSeconds() const { return m_step.count(); }
+    // simulation time thrown away by the catch-up limit
+    inline double getDroppedSeconds() const { return m_dropped.count(); }
+
+    // feeds the wall time elapsed since the previous call into the accumulator.
+    // frameWanted false: only the simulation advances, the render cap slot is kept for the next frame
+    Tick advance(bool frameWanted = true);
+    // forgets the time spent idle, the next advance() starts from now without catching up
+    void reset();
+    // how long the loop may sleep before the next fixed step is due
+    Clock::duration timeUntilNextUpdate() const;
+    // how long the render cap holds back the next frame, always 0 when uncapped
+    Clock::duration timeUntilNextFrame() const;
+
+private:
+    using Seconds = std::chrono::duration<double>;
+
+    double m_updateRate;
+    double m_renderCap;
+    uint32_t m_maxUpdates = DEFAULT_MAX_UPDATES;
+
+    Seconds m_step;
+    Seconds m_renderInterval{0.0};
+    Seconds m_accumulator{0.0};
+    Seconds m_dropped{0.0};
+
+    Clock::time_point m_lastAdvance;
+    Clock::time_point m_lastRender;
+};
+
+}   // namespace moo
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace moo {
+
+// Level of detail chains built from a triangle list. Simplification collapses edges onto existing
+// vertices, cheapest first by quadric error (Garland-Heckbert): the vertex buffer is untouched,
+// each LOD is just a shorter index list. Vertices sharing a position collapse together but keep
+// their attributes: a triangle moved onto a seam takes the copy whose attributes are closest to
+// its own vertex's, and seams collapse only along themselves. Borders collapse only along
+// themselves too, with a penalty keeping their shape; a collapse that would flip a triangle is
+// skipped. Errors are distances relative to the mesh bounding radius (largest distance from the
+// bounding box center, as VulkanModel::Builder::getBoundingSphere), so a LOD's error times the
+// mesh's radius on screen is its error in pixels.
+class MMeshSimplifier {
+public:
+    static constexpr uint32_t MAX_LODS = 6;
+    static constexpr float MAX_ERROR = 0.05f;       // a LOD never deviates more than this, in radii
+    static constexpr float HYSTERESIS = 0.25f;      // margin around the pixel error threshold
+
+    // a range of the mesh's index buffer, LOD 0 first, coarser after
+    struct Lod {
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        float error = 0.0f;     // from LOD 0, fraction of the bounding radius
+    };
+
+    // positions: xyz floats stride bytes apart. attributes: attributeCount floats per vertex, same
+    // stride, nullptr if none. Stops at targetIndexCount or when the next collapse would exceed
+    // maxError, error: the deviation reached
+    static std::vector<uint32_t> simplify(const float *positions, const float *attributes, size_t attributeCount,
+        size_t vertexCount, size_t stride, const std::vector<uint32_t> &indices, size_t targetIndexCount,
+        float maxError = MAX_ERROR, float *error = nullptr);
+
+    // appends each LOD to indices (triangles halved each step by default) and returns the ranges;
+    // fewer than maxLods when simplifying stops paying off
+    static std::vector<Lod> buildLodChain(const float *positions, const float *attributes, size_t attributeCount,
+        size_t vertexCount, size_t stride, std::vector<uint32_t> &indices, uint32_t maxLods = MAX_LODS, float reduction = 0.5f);
+
+    // coarsest LOD whose error stays under maxPixelError for a bounding sphere screenRadius pixels
+    // large. current: the renderable's LOD last frame, kept until another one is better by HYSTERESIS
+    static uint32_t selectLod(const std::vector<Lod> &lods, float screenRadius, float maxPixelError, uint32_t current = UINT32_MAX);
+    // bounding sphere radius in pixels, perspective projection with vertical field of view fovY
+    static float projectedRadius(float radius, float distance, float fovY, float viewportHeight);
+};
+
+}   // namespace moo
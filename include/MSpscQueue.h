@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace moo {
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4324) // producer and consumer indices padded onto their own cache lines
+#endif
+
+// Bounded single-producer single-consumer ring, wait-free on both sides.
+// Indices grow monotonically and are masked on access, so full and empty are unambiguous.
+template <typename T, size_t Capacity>
+class MSpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SPSC queue capacity must be a power of two.");
+
+public:
+    // producer side, returns false when full
+    bool push(const T& value) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+
+        m_buffer[head & (Capacity - 1)] = value;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side, returns false when empty
+    bool pop(T& value) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        value = m_buffer[tail & (Capacity - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> m_head {0};
+    alignas(64) std::atomic<size_t> m_tail {0};
+    std::array<T, Capacity> m_buffer {};
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+}   // namespace moo
\ No newline at end of file
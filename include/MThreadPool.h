@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace moo {
+
+// Fixed set of worker threads draining a FIFO of jobs.
+// submit() returns a future, an exception thrown by the job is rethrown by future::get().
+class MThreadPool {
+public:
+    // 0 = one worker per core, minus one for the thread that submits
+    explicit MThreadPool(uint32_t threadCount = 0);
+    // finishes the queued jobs before joining
+    ~MThreadPool();
+
+    MThreadPool(const MThreadPool&) = delete;
+    MThreadPool& operator=(const MThreadPool&) = delete;
+
+    template <typename F>
+    auto submit(F&& job) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+
+        // std::function needs a copyable target, the task itself is move-only
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+        std::future<Result> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.emplace_back([task]() { (*task)(); });
+        }
+        m_wake.notify_one();
+
+        return result;
+    }
+
+    inline uint32_t threadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_jobs;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+
+    void workerLoop();
+};
+
+}   // namespace moo
@@ -3,10 +3,16 @@
 #include <SDL.h>
 #include "vk_types.h"
 
+#include <atomic>
+#include <functional>
+#include <mutex>
 #include <string>
 
 namespace moo {
 
+// Events are handled on the thread that created the window (SDL requirement).
+// State read by the renderer (extent, minimized, resized, redraw, quit) is atomic,
+// so it can run on its own thread.
 class MWindow {
 public:
     MWindow(std::string title, int w, int h);
@@ -16,23 +22,61 @@ public:
     MWindow &operator=(const MWindow&) = delete;// copy operator
 
     void handleEvent(SDL_Event& event);
+    // handles every pending event; with block set, sleeps up to timeoutMs for the first one
+    // instead of returning immediately, so an idle loop doesn't spin
+    void processEvents(bool block, int timeoutMs);
     void createWindowSurface(VkInstance instance, VkSurfaceKHR *surface);
+    // appends text to the window title, cheapest on-screen overlay available without a text renderer.
+    // Callable from any thread, the title is applied by the next processEvents
+    void setTitleOverlay(const std::string& text);
+    // called by processEvents for every event once the window has handled it, on the event thread
+    inline void setEventListener(std::function<void(const SDL_Event&)> listener) { m_eventListener = std::move(listener); }
+    // callable from any thread: flags the window as closing and wakes up the event loop
+    void requestClose();
 
-    inline VkExtent2D getExtent() { return {static_cast<uint32_t>(m_width), static_cast<uint32_t>(m_height)}; }
+    // width and height live in one word so a reader never sees half of a resize
+    inline VkExtent2D getExtent() {
+        uint64_t extent = m_extent.load(std::memory_order_acquire);
+        return {static_cast<uint32_t>(extent >> 32), static_cast<uint32_t>(extent & 0xffffffff)};
+    }
     inline bool isMinimized() { return m_minimized; }
     inline bool wasWindowResized() { return m_framebufferResized; }
     inline void resetWindowResizedFlag() { m_framebufferResized = false; }
     inline bool isClosing() { return m_quit; }
 
+    // idle mode: window/input events and the redraw timer request a new frame,
+    // a static scene isn't redrawn until something changes
+    inline bool needsRedraw() { return m_redrawRequested; }
+    inline void requestRedraw() { m_redrawRequested = true; }
+    inline void resetRedrawRequest() { m_redrawRequested = false; }
+    // periodic redraw for animations, 0 stops the timer
+    void setRedrawInterval(uint32_t milliseconds);
+
     static int resizingEventWatcher(void* data, SDL_Event* event);
+    static Uint32 redrawTimerCallback(Uint32 interval, void* data);
 
 private:
     SDL_Window* m_window;
     std::string m_windowTitle;
-    int m_width, m_height;
-    bool m_quit, m_framebufferResized, m_fullscreen, m_minimized;
+    std::atomic<uint64_t> m_extent;
+    std::atomic<bool> m_quit, m_framebufferResized, m_minimized;
+    std::atomic<bool> m_redrawRequested;
+    bool m_fullscreen;
+
+    Uint32 m_redrawEventType;
+    SDL_TimerID m_redrawTimer;
+
+    std::function<void(const SDL_Event&)> m_eventListener;
+
+    std::mutex m_titleMutex;
+    std::string m_pendingTitle;
+    std::atomic<bool> m_titleDirty;
 
     void init();
+
+    static inline uint64_t packExtent(int w, int h) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(w)) << 32) | static_cast<uint32_t>(h);
+    }
 };
 
 }   // namespace moo
\ No newline at end of file
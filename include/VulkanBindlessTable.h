@@ -0,0 +1,93 @@
+#pragma once
+
+#include "VulkanCommandEncoder.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace moo {
+
+// Every texture and buffer of the scene in one descriptor set, bound once per frame: shaders
+// index a sampler2D[] at TEXTURE_BINDING and a buffer[] at BUFFER_BINDING with indices pushed per
+// draw (VulkanModel::PushConstants), so drawing with another material binds nothing. Both arrays
+// are update-after-bind and partially bound: slots are written while the set is in use by
+// pending frames, unwritten ones just must not be read. Indices are stable until removed; a
+// removed index is reused framesInFlight beginFrame() calls later, once no frame can read it.
+// Needs descriptor indexing (Vulkan 1.2), see enableFeatures(). Not thread-safe.
+class VulkanBindlessTable {
+public:
+    static constexpr uint32_t TEXTURE_BINDING = 0;
+    static constexpr uint32_t BUFFER_BINDING = 1;
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+    static constexpr uint32_t MAX_TEXTURES = 1 << 16;   // upper bound, lowered to the device limits
+    static constexpr uint32_t MAX_BUFFERS = 1 << 16;
+
+    // array sizes, 0: bindless unavailable
+    struct Capacity {
+        uint32_t textures = 0;
+        uint32_t buffers = 0;
+    };
+
+    struct Stats {
+        uint32_t textures = 0;      // live indices
+        uint32_t buffers = 0;
+    };
+
+    // before vkCreateDevice: sets the descriptor indexing features into features (chained to the
+    // device create info by the caller) when the GPU has all of them
+    static Capacity enableFeatures(VkPhysicalDevice gpu, VkPhysicalDeviceVulkan12Features &features);
+
+    VulkanBindlessTable(VkDevice device, Capacity capacity, uint32_t framesInFlight);
+    ~VulkanBindlessTable();
+
+    VulkanBindlessTable(const VulkanBindlessTable&) = delete;
+    VulkanBindlessTable& operator=(const VulkanBindlessTable&) = delete;
+
+    // the oldest frame in flight has completed: indices it could read are free again
+    void beginFrame();
+
+    // INVALID_INDEX: the array is full
+    uint32_t addTexture(VkImageView view, VkSampler sampler, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    uint32_t addBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    // the resource has to stay alive until frames recorded before the removal completed
+    void removeTexture(uint32_t index);
+    void removeBuffer(uint32_t index);
+
+    // layout: has getSetLayout() at set
+    void bind(VulkanCommandEncoder &encoder, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t set = 0);
+
+    inline VkDescriptorSetLayout getSetLayout() const { return m_setLayout; }
+    inline Capacity getCapacity() const { return m_capacity; }
+    Stats getStats() const;
+
+private:
+    // stable indices: freed ones wait framesInFlight frames, then are reused before new ones
+    struct IndexAllocator {
+        uint32_t capacity = 0;
+        uint32_t next = 0;                              // never handed out from here on
+        std::vector<uint32_t> free;
+        std::vector<std::pair<uint32_t, uint64_t>> retired;    // index, frame it was removed in
+
+        uint32_t allocate();
+        void release(uint32_t index, uint64_t frame);
+        void recycle(uint64_t completedFrame);
+        uint32_t live() const;
+    };
+
+    VkDevice m_device;
+    Capacity m_capacity;
+    uint32_t m_framesInFlight;
+    uint64_t m_frame = 0;
+
+    VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+    VkDescriptorPool m_pool = VK_NULL_HANDLE;
+    VkDescriptorSet m_set = VK_NULL_HANDLE;
+
+    IndexAllocator m_textures;
+    IndexAllocator m_buffers;
+
+    void createSetLayout();
+    void createSet();
+};
+
+}   // namespace moo
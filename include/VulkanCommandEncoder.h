@@ -0,0 +1,122 @@
+#pragma once
+
+#include "VulkanDynamicState.h"
+#include "VulkanPushConstants.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace moo {
+
+// Records into one command buffer at a time and remembers what it bound: a pipeline, vertex or
+// index buffer, descriptor set, push constant block, viewport or scissor equal to what the command
+// buffer already holds is not recorded again. Dynamic state goes through the VulkanDynamicState it
+// owns. Binding a graphics pipeline forgets the tracked states it doesn't declare dynamic: it
+// overwrote them. Counts issued and elided calls since begin(), i.e. per recorded frame.
+// Calls made on the command buffer directly are not seen: after one, invalidate().
+class VulkanCommandEncoder {
+public:
+    static constexpr uint32_t MAX_VERTEX_BINDINGS = 8;      // tracked, higher bindings are always recorded
+    static constexpr uint32_t MAX_DESCRIPTOR_SETS = 4;      // maxBoundDescriptorSets guaranteed minimum
+    static constexpr uint32_t MAX_PUSH_CONSTANT_SIZE = GUARANTEED_PUSH_CONSTANTS_SIZE;
+
+    enum class Command : uint32_t {
+        Pipeline = 0,
+        VertexBuffers,
+        IndexBuffer,
+        DescriptorSets,
+        PushConstants,
+        Viewport,
+        Scissor,
+        DynamicState,   // VulkanDynamicState vkCmdSet* calls
+        Count
+    };
+
+    // tracked states a pipeline declares dynamic, binding it keeps them
+    enum DynamicStates : uint32_t {
+        DynamicViewport = 1 << 0,
+        DynamicScissor = 1 << 1,
+        DynamicExtended = 1 << 2,   // all of VulkanDynamicState::DYNAMIC_STATES
+    };
+
+    struct Stats {
+        std::array<uint32_t, static_cast<size_t>(Command::Count)> issued{};
+        std::array<uint32_t, static_cast<size_t>(Command::Count)> elided{};
+
+        uint32_t totalIssued() const;
+        uint32_t totalElided() const;
+    };
+
+    // new command buffer: nothing is bound, the stats start over
+    void begin(VkCommandBuffer commandBuffer);
+    // the command buffer was changed behind the encoder's back: record everything again
+    void invalidate();
+
+    // DynamicStates of a pipeline's dynamic state list
+    static uint32_t dynamicStatesOf(const std::vector<VkDynamicState> &dynamicStates);
+
+    // dynamicStates: the pipeline's DynamicStates, 0 treats every tracked state as baked in
+    void bindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline, uint32_t dynamicStates = 0);
+    void bindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer *buffers, const VkDeviceSize *offsets);
+    void bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+    // dynamic offsets are always recorded
+    void bindDescriptorSets(VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t setCount,
+        const VkDescriptorSet *sets, uint32_t dynamicOffsetCount = 0, const uint32_t *dynamicOffsets = nullptr);
+    void pushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void *data);
+    // Block: a VulkanPushConstantBlock whose range is in the layout
+    template <typename Block>
+    void push(VkPipelineLayout layout, const typename Block::Type &value) {
+        pushConstants(layout, Block::STAGES, Block::OFFSET, Block::SIZE, &value);
+    }
+    void setViewport(const VkViewport &viewport);
+    void setScissor(const VkRect2D &scissor);
+
+    inline VkCommandBuffer getCommandBuffer() const { return m_commandBuffer; }
+    inline VulkanDynamicState& getDynamicState() { return m_dynamicState; }
+    Stats getStats() const;
+
+private:
+    // graphics and compute
+    struct BindPointState {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkPipelineLayout layout = VK_NULL_HANDLE;       // of the bound sets
+        std::array<VkDescriptorSet, MAX_DESCRIPTOR_SETS> sets{};
+    };
+
+    struct VertexBinding {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+    };
+
+    struct PushConstantBlock {
+        VkPipelineLayout layout = VK_NULL_HANDLE;       // VK_NULL_HANDLE: nothing pushed
+        VkShaderStageFlags stages = 0;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+        std::array<uint8_t, MAX_PUSH_CONSTANT_SIZE> data{};
+    };
+
+    VkCommandBuffer m_commandBuffer = VK_NULL_HANDLE;
+    VulkanDynamicState m_dynamicState;
+
+    std::array<BindPointState, 2> m_bindPoints{};
+    std::array<VertexBinding, MAX_VERTEX_BINDINGS> m_vertexBindings{};
+    VkBuffer m_indexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize m_indexOffset = 0;
+    VkIndexType m_indexType = VK_INDEX_TYPE_UINT32;
+    PushConstantBlock m_pushConstants{};
+    VkViewport m_viewport{};
+    VkRect2D m_scissor{};
+    bool m_viewportSet = false;
+    bool m_scissorSet = false;
+
+    Stats m_stats{};
+    uint64_t m_dynamicRecorded = 0;     // m_dynamicState counters at begin()
+    uint64_t m_dynamicSkipped = 0;
+
+    BindPointState& bindPointState(VkPipelineBindPoint bindPoint);
+    void count(Command command, bool issued);
+};
+
+}   // namespace moo
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "VulkanDevice.h"
+#include "VulkanSpecialization.h"
+
+#include <string>
+#include <vector>
+
+namespace moo {
+
+// Compute shader with its own layout: one descriptor set of storage/uniform buffers (set = 0)
+// and an optional push constant block. Descriptor sets come from a pool owned by the pipeline.
+// Dispatches are recorded in the graphics command buffer (the graphics family also does compute),
+// barrier() makes the results visible to whatever reads them next.
+class VulkanComputePipeline {
+public:
+    struct ComputeConfigInfo {
+        std::vector<VkDescriptorSetLayoutBinding> bindings;     // descriptorCount 1 each
+        uint32_t pushConstantSize = 0;                          // bytes, 0 = none
+        uint32_t maxDescriptorSets = 1;                         // e.g. one per frame in flight
+
+        VulkanSpecialization specialization;                    // e.g. the workgroup size
+    };
+
+    // who reads the buffer a dispatch wrote
+    enum class Consumer {
+        Compute,        // the next dispatch
+        VertexInput,    // vertex/index buffer
+        VertexShader,   // storage buffer read while drawing
+        Indirect,       // vkCmdDraw*Indirect / vkCmdDispatchIndirect arguments
+        Transfer,       // copy
+        Host,           // mapped read after the fence
+    };
+
+    VulkanComputePipeline(VulkanDevice &device, const std::string &compFilepath, const ComputeConfigInfo &configInfo);
+    ~VulkanComputePipeline();
+
+    VulkanComputePipeline(const VulkanComputePipeline&) = delete;
+    VulkanComputePipeline& operator=(const VulkanComputePipeline&) = delete;
+
+    inline VkPipeline getPipeline() const { return m_pipeline; }
+    inline VkPipelineLayout getLayout() const { return m_pipelineLayout; }
+    inline VkDescriptorSetLayout getDescriptorSetLayout() const { return m_descriptorSetLayout; }
+
+    // from the pipeline pool, freed with the pipeline
+    VkDescriptorSet allocateDescriptorSet();
+    // binding must be one of configInfo.bindings
+    void writeBuffer(VkDescriptorSet set, uint32_t binding, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+    void bind(VkCommandBuffer commandBuffer);
+    void bindDescriptorSet(VkCommandBuffer commandBuffer, VkDescriptorSet set);
+    void pushConstants(VkCommandBuffer commandBuffer, const void *data, uint32_t size);
+    template <typename T>
+    void pushConstants(VkCommandBuffer commandBuffer, const T &data) { pushConstants(commandBuffer, &data, static_cast<uint32_t>(sizeof(T))); }
+
+    void dispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY = 1, uint32_t groupCountZ = 1);
+    // one invocation per element, the shader has to skip the ones past the end
+    void dispatchElements(VkCommandBuffer commandBuffer, uint32_t elementCount, uint32_t localSizeX);
+    // group counts read from a VkDispatchIndirectCommand written by the GPU
+    void dispatchIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset = 0);
+
+    static inline uint32_t groupCount(uint32_t elementCount, uint32_t localSize) { return (elementCount + localSize - 1) / localSize; }
+    // compute shader writes to buffer -> consumer reads
+    static void barrier(VkCommandBuffer commandBuffer, VkBuffer buffer, Consumer consumer, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+private:
+    VulkanDevice& m_device;
+
+    VkDescriptorSetLayout m_descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool m_descriptorPool = VK_NULL_HANDLE;
+    VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline m_pipeline = VK_NULL_HANDLE;
+
+    std::vector<VkDescriptorSetLayoutBinding> m_bindings;
+    uint32_t m_pushConstantSize;
+
+    void createLayout(const ComputeConfigInfo &configInfo);
+    void createDescriptorPool(const ComputeConfigInfo &configInfo);
+    void createPipeline(const std::string &compFilepath, const ComputeConfigInfo &configInfo);
+};
+
+}   // namespace moo
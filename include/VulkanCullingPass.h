@@ -0,0 +1,97 @@
+#pragma once
+
+#include "VulkanComputePipeline.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "glm/mat4x4.hpp"
+#include "glm/vec4.hpp"
+
+#include <array>
+#include <vector>
+
+namespace moo {
+
+// GPU-driven draws: every renderable's bounding sphere and draw arguments live in a storage
+// buffer, a compute pass tests them against the frustum and appends the visible ones to an
+// indirect buffer, then a single vkCmdDrawIndexedIndirectCount draws them. The CPU records the
+// same few commands whatever the object count.
+//
+// CULL_SHADER_FILE interface, compiled from shaders/cull.comp (set = 0):
+//   binding 0  readonly buffer  Object objects[]
+//   binding 1  buffer           VkDrawIndexedIndirectCommand draws[]
+//   binding 2  buffer           uint drawCount
+//   push constant               CullConstants
+//   constant_id 0  local_size_x (LOCAL_SIZE)
+//   constant_id 1  bool COMPACT: append visible objects at atomicAdd(drawCount, 1), otherwise
+//                  write every object in place with instanceCount 0 when culled
+class VulkanCullingPass {
+public:
+    static constexpr const char* CULL_SHADER_FILE = "./../shaders/cull.comp.spv";
+    static constexpr uint32_t LOCAL_SIZE = 64;
+
+    // std430, 32 bytes
+    struct Object {
+        glm::vec4 boundingSphere;   // xyz world space center, w radius
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t firstInstance;     // gl_InstanceIndex of the draw, e.g. to index per-object data
+    };
+
+    struct CullConstants {
+        std::array<glm::vec4, 6> planes;    // xyz inward normal, w distance
+        uint32_t objectCount;
+        uint32_t padding[3];
+    };
+
+    // the compiled CULL_SHADER_FILE is there, the buffers fit the device limits and the device is a
+    // GPU: software rasterizers run the dispatch on the CPU, where MFrustumCuller does better
+    static bool isSupported(VulkanDevice &device, uint32_t capacity);
+
+    // slots: one per command buffer that may be in flight
+    VulkanCullingPass(VulkanDevice &device, uint32_t capacity, uint32_t slots);
+    ~VulkanCullingPass();
+
+    VulkanCullingPass(const VulkanCullingPass&) = delete;
+    VulkanCullingPass& operator=(const VulkanCullingPass&) = delete;
+
+    // staged to device local memory: the GPU must be done with the previous objects.
+    // Returns the objects kept, capped by the capacity
+    uint32_t setObjects(const std::vector<Object> &objects);
+
+    // outside a render pass
+    void cull(VkCommandBuffer commandBuffer, uint32_t slot, const glm::mat4 &viewProjection);
+    // inside the render pass, with the pipeline, vertex and index buffers shared by every object bound
+    void draw(VkCommandBuffer commandBuffer, uint32_t slot);
+
+    inline uint32_t getObjectCount() const { return m_objectCount; }
+    inline uint32_t getCapacity() const { return m_capacity; }
+
+    // normalized, for GLM_FORCE_DEPTH_ZERO_TO_ONE clip space: left, right, bottom, top, near, far
+    static std::array<glm::vec4, 6> extractFrustumPlanes(const glm::mat4 &viewProjection);
+
+private:
+    struct Slot {
+        VkBuffer drawBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory drawMemory = VK_NULL_HANDLE;
+        VkBuffer countBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory countMemory = VK_NULL_HANDLE;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    };
+
+    VulkanDevice& m_device;
+    VulkanComputePipeline m_pipeline;
+    bool m_compact;             // drawIndirectCount: survivors packed, draw count read by the GPU
+
+    VkBuffer m_objectBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_objectMemory = VK_NULL_HANDLE;
+    uint32_t m_capacity;
+    uint32_t m_objectCount = 0;
+
+    std::vector<Slot> m_slots;
+
+    static VulkanComputePipeline::ComputeConfigInfo configInfo(VulkanDevice &device, uint32_t slots);
+};
+
+}   // namespace moo
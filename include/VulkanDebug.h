@@ -17,6 +17,12 @@ struct VulkanDebug {
         void* pUserData
     );
 
+    // messages are keyed by messageIdNumber + object handles: only the first occurrence is
+    // logged, repeats are counted and reported in a summary every SUMMARY_INTERVAL_SECONDS.
+    // The summary runs on the logger's writer thread, so it keeps coming after the messages stop
+    static constexpr int64_t SUMMARY_INTERVAL_SECONDS = 5;
+    static void printSummary();
+
     // load debug function pointers and set debug callback
     // if callback NULL, default message callback will be used
     void setupDebugging(VkInstance instance);
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "VulkanLayoutCache.h"
+
+#include <unordered_set>
+#include <vector>
+
+namespace moo {
+
+// Descriptor sets from pools that grow instead of failing. Transient sets come from the pools of
+// a frame slot (one per command buffer in flight): beginFrame() resets all of them with one
+// vkResetDescriptorPool each, no per-set free, so an allocation is a pool bump. When a pool runs
+// out (VK_ERROR_OUT_OF_POOL_MEMORY / FRAGMENTED_POOL) it is retired until the next reset and a
+// larger one is created. Persistent sets live in pools of their own until the allocator goes.
+// Layouts are the layout cache's: equal bindings, same layout. Pools hold the types of the
+// ratios, plus any other type a layout allocated from needs: the first set of such a layout
+// retires the pools created without it.
+class VulkanDescriptorAllocator {
+public:
+    // descriptors of a type per set in a pool: a pool for N sets holds N * ratio of them
+    struct PoolSizeRatio {
+        VkDescriptorType type;
+        float ratio;
+    };
+
+    struct Stats {
+        uint32_t pools = 0;             // created, all slots
+        uint32_t transientSets = 0;     // since the last beginFrame()
+        uint32_t persistentSets = 0;
+    };
+
+    static constexpr uint32_t INITIAL_SETS_PER_POOL = 64;
+    static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+    VulkanDescriptorAllocator(VkDevice device, VulkanLayoutCache &layoutCache, uint32_t frames);
+    VulkanDescriptorAllocator(VkDevice device, VulkanLayoutCache &layoutCache, uint32_t frames, std::vector<PoolSizeRatio> ratios);
+    ~VulkanDescriptorAllocator();
+
+    VulkanDescriptorAllocator(const VulkanDescriptorAllocator&) = delete;
+    VulkanDescriptorAllocator& operator=(const VulkanDescriptorAllocator&) = delete;
+
+    // the frame's previous command buffer has completed: its transient sets are released
+    void beginFrame(uint32_t frame);
+
+    // valid until the current frame slot is reset
+    VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+    VkDescriptorSet allocate(std::vector<VkDescriptorSetLayoutBinding> bindings);
+    // valid as long as the allocator
+    VkDescriptorSet allocatePersistent(VkDescriptorSetLayout layout);
+
+    Stats getStats() const;
+
+private:
+    // growable pool list: allocations go to the last ready pool
+    struct Pools {
+        std::vector<VkDescriptorPool> ready;
+        std::vector<VkDescriptorPool> full;
+        std::vector<VkDescriptorPool> stale;    // created before the sizes last grew, destroyed on reset
+        uint32_t setsPerPool = INITIAL_SETS_PER_POOL;
+        uint32_t allocated = 0;
+    };
+
+    VkDevice m_device;
+    VulkanLayoutCache& m_layoutCache;
+    std::vector<PoolSizeRatio> m_ratios;
+    std::vector<uint32_t> m_minCounts;                  // per ratio: the largest set allocated so far
+    std::unordered_set<VkDescriptorSetLayout> m_fitted; // layouts the pool sizes already cover
+
+    std::vector<Pools> m_frames;
+    uint32_t m_frame = 0;
+    Pools m_persistent;
+    uint32_t m_poolCount = 0;
+
+    VkDescriptorSet allocate(Pools &pools, VkDescriptorSetLayout layout);
+    // grows the pool sizes to hold a set of layout, retiring every pool created before
+    void fitLayout(VkDescriptorSetLayout layout);
+    VkDescriptorPool getPool(Pools &pools);
+    VkDescriptorPool createPool(uint32_t setCount);
+};
+
+}   // namespace moo
@@ -1,7 +1,13 @@
 #pragma once
 
+#include "VulkanBindlessTable.h"
 #include "VulkanDebug.h"
+#include "VulkanLayoutCache.h"
+#include "VulkanPipelineCache.h"
+#include "VulkanPipelineLibrary.h"
+#include "VulkanShaderCache.h"
 
+#include <memory>
 #include <vector>
 #include <optional>
 
@@ -27,6 +33,8 @@ struct SwapChainSupportDetails {
 
 class VulkanDevice {
 public:
+    static constexpr const char* PIPELINE_CACHE_FILE = "pipeline_cache.bin";
+
     VkPhysicalDeviceProperties m_deviceProperties;
     VkPhysicalDeviceFeatures m_deviceFeatures;
     VkPhysicalDeviceMemoryProperties m_deviceMemoryProperties;
@@ -46,8 +54,19 @@ private:
 
     VkCommandPool m_commandPool;
 
+    // shared by every pipeline created on this device
+    std::unique_ptr<VulkanPipelineCache> m_pipelineCache;
+    std::unique_ptr<VulkanShaderCache> m_shaderCache;
+    std::unique_ptr<VulkanLayoutCache> m_layoutCache;
+    std::unique_ptr<VulkanPipelineLibrary> m_pipelineLibrary;
+    bool m_graphicsPipelineLibrary = false;     // feature enabled and fast linking
+    bool m_drawIndirectCount = false;
+    bool m_bindless = false;                    // descriptor indexing requested at creation
+    VulkanBindlessTable::Capacity m_bindlessCapacity{};
+
 public:
-    VulkanDevice(MWindow &window);
+    // bindless: enable descriptor indexing for a VulkanBindlessTable when the GPU has it
+    VulkanDevice(MWindow &window, bool bindless = false);
     ~VulkanDevice();
 
     // Not copyable or movable
@@ -65,6 +84,18 @@ public:
 
     inline VkSurfaceKHR getSurface() { return m_surface; }
     inline VkCommandPool getCommandPool() { return m_commandPool; }
+    inline VulkanPipelineCache& getPipelineCache() { return *m_pipelineCache; }
+    inline VulkanShaderCache& getShaderCache() { return *m_shaderCache; }
+    // layouts reflected from the shaders, shared by compatible pipelines
+    inline VulkanLayoutCache& getLayoutCache() { return *m_layoutCache; }
+    // check isSupported(): monolithic pipelines otherwise
+    inline VulkanPipelineLibrary& getPipelineLibrary() { return *m_pipelineLibrary; }
+    // true for required extensions and for optional ones the GPU supports
+    bool isExtensionEnabled(const char* extensionName) const;
+    // vkCmdDrawIndexedIndirectCount available
+    inline bool isDrawIndirectCountEnabled() const { return m_drawIndirectCount; }
+    // requested and descriptor indexing enabled: array sizes for a VulkanBindlessTable, 0 otherwise
+    inline VulkanBindlessTable::Capacity getBindlessCapacity() const { return m_bindlessCapacity; }
 
 // buffer
     void createBuffer(
@@ -99,12 +130,27 @@ private:
     void pickPhysicalDevice();
     void createLogicalDevice();
     void createCommandPool();
+    void createPipelineCache();
+    void createShaderCache();
+    void createLayoutCache();
+    void createPipelineLibrary();
 
 // helper functions
 // instance start
     std::vector<const char *> m_instanceExtensions;
     const std::vector<const char *> m_validationLayers = {"VK_LAYER_KHRONOS_validation"};
     const std::vector<const char *> m_deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    // enabled only when available, features built on them check isExtensionEnabled
+    const std::vector<const char *> m_optionalDeviceExtensions = {
+#ifdef VK_KHR_maintenance5
+        VK_KHR_MAINTENANCE_5_EXTENSION_NAME,
+#endif
+#ifdef VK_EXT_graphics_pipeline_library
+        VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
+        VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME,
+#endif
+    };
+    std::vector<const char *> m_enabledDeviceExtensions;
 
     bool checkValidationLayerSupport(std::vector<const char *> validationLayers);
     // will return the required list of extensions based on which validation layers are enabled or not
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "vk_types.h"
+
+#include <array>
+#include <vector>
+
+namespace moo {
+
+// Vulkan 1.3 extended dynamic state: cull mode, front face, topology and depth test/write/compare
+// are set while recording instead of being baked in, one pipeline covers every combination
+// (the registry leaves them out of the pipeline key). Tracks what the command buffer already
+// holds and skips the redundant vkCmdSet* calls.
+class VulkanDynamicState {
+public:
+    struct State {
+        VkCullModeFlags cullMode = VK_CULL_MODE_NONE;
+        VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+        VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;    // same topology class as the pipeline's
+        VkBool32 depthTestEnable = VK_FALSE;
+        VkBool32 depthWriteEnable = VK_FALSE;
+        VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+    };
+
+    static constexpr std::array<VkDynamicState, 6> DYNAMIC_STATES = {
+        VK_DYNAMIC_STATE_CULL_MODE,
+        VK_DYNAMIC_STATE_FRONT_FACE,
+        VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY,
+        VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE,
+        VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE,
+        VK_DYNAMIC_STATE_DEPTH_COMPARE_OP,
+    };
+
+    // core in Vulkan 1.3, no feature to enable
+    static bool isSupported(const VkPhysicalDeviceProperties& properties);
+    // appends DYNAMIC_STATES the list doesn't have yet
+    static void addDynamicStates(std::vector<VkDynamicState>& dynamicStates);
+
+    // new command buffer: nothing is known, the first set of each state is recorded
+    void begin(VkCommandBuffer commandBuffer);
+    // a pipeline with these states baked in was bound, it overwrote them
+    void invalidate();
+
+    void apply(const State& state);
+    void setCullMode(VkCullModeFlags cullMode);
+    void setFrontFace(VkFrontFace frontFace);
+    void setPrimitiveTopology(VkPrimitiveTopology topology);
+    void setDepthTestEnable(VkBool32 enable);
+    void setDepthWriteEnable(VkBool32 enable);
+    void setDepthCompareOp(VkCompareOp compareOp);
+
+    inline uint64_t getRecordedCount() const { return m_recorded; }
+    inline uint64_t getSkippedCount() const { return m_skipped; }
+
+private:
+    enum Bit : uint32_t {
+        CullMode = 1 << 0,
+        FrontFace = 1 << 1,
+        Topology = 1 << 2,
+        DepthTest = 1 << 3,
+        DepthWrite = 1 << 4,
+        DepthCompare = 1 << 5,
+    };
+
+    VkCommandBuffer m_commandBuffer = VK_NULL_HANDLE;
+    State m_state{};
+    uint32_t m_known = 0;   // Bit set: m_state holds what the command buffer has
+
+    uint64_t m_recorded = 0;
+    uint64_t m_skipped = 0;
+
+    // true when the call has to be recorded
+    template <typename T>
+    bool update(Bit bit, T& current, T value);
+};
+
+}   // namespace moo
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "VulkanShaderReflection.h"
+
+#include <atomic>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace moo {
+
+// Descriptor set layouts and pipeline layouts built from shader reflection, one object per
+// distinct interface. Shaders declaring the same set get the same VkDescriptorSetLayout, so
+// pipelines sharing a set (and the push constant range) have compatible layouts: sets bound
+// once stay valid when switching between them, no rebind. Owns every layout. Thread-safe.
+class VulkanLayoutCache {
+public:
+    struct Layout {
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSetLayout> setLayouts;      // indexed by set number, unused sets are empty layouts
+        VkPushConstantRange pushConstants {};               // size 0: none
+    };
+
+    struct Stats {
+        uint32_t setLayouts = 0;
+        uint32_t pipelineLayouts = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    explicit VulkanLayoutCache(VkDevice device);
+    // every pipeline created with these layouts must be destroyed first
+    ~VulkanLayoutCache();
+
+    VulkanLayoutCache(const VulkanLayoutCache&) = delete;
+    VulkanLayoutCache& operator=(const VulkanLayoutCache&) = delete;
+
+    // the stages of one pipeline: bindings used by several stages are merged,
+    // the push constant range spans every stage's block. pushConstants (a VulkanPushConstantBlock
+    // range) replaces it, it has to cover what the shaders declare
+    Layout getLayout(std::initializer_list<const VulkanShaderReflection*> stages, const VkPushConstantRange& pushConstants = {});
+    // bindings in any order, descriptorCount 0 (runtime arrays) is not supported: see VulkanBindlessTable
+    VkDescriptorSetLayout getSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings);
+    VkPipelineLayout getPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const VkPushConstantRange& pushConstants);
+    // descriptors of each type one set of setLayout takes, empty for layouts not from this cache
+    std::vector<VkDescriptorPoolSize> getPoolSizes(VkDescriptorSetLayout setLayout);
+
+    Stats getStats();
+
+private:
+    // the fields hashed, compared on a hit: a hash collision is a miss, not another layout
+    struct Key {
+        uint64_t hash = 14695981039346656037ULL;
+        std::vector<uint64_t> fields;
+
+        void add(uint64_t value);
+        inline bool operator==(const Key& other) const { return hash == other.hash && fields == other.fields; }
+    };
+
+    struct KeyHash {
+        inline size_t operator()(const Key& key) const { return static_cast<size_t>(key.hash); }
+    };
+
+    VkDevice m_device;
+
+    std::mutex m_mutex;
+    std::unordered_map<Key, VkDescriptorSetLayout, KeyHash> m_setLayouts;
+    std::unordered_map<Key, VkPipelineLayout, KeyHash> m_pipelineLayouts;
+    std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorPoolSize>> m_poolSizes;
+
+    std::atomic<uint64_t> m_hits {0};
+    std::atomic<uint64_t> m_misses {0};
+};
+
+}   // namespace moo
@@ -1,7 +1,12 @@
 #pragma once
 
 #include "vk_types.h"
+#include "MMeshSimplifier.h"
+#include "VulkanCommandEncoder.h"
+#include "VulkanPushConstants.h"
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
 
 #include <vector>
 
@@ -19,9 +24,17 @@ struct Vertex {
     static VertexInputDescription getVertexInputDescription();    
 };
 
+// per-draw constants of the default pipeline
+struct MeshPushConstants {
+    glm::vec4 data;
+    glm::mat4 render_matrix;
+};
+using MeshPushBlock = moo::VulkanPushConstantBlock<MeshPushConstants, VK_SHADER_STAGE_VERTEX_BIT>;
+
 struct Mesh {
     std::vector<uint32_t> indices;
     std::vector<Vertex> vertices;
+    std::vector<moo::MMeshSimplifier::Lod> lods;   // ranges of indices, empty: all of them
 
     size_t indices_size, vertices_size;
     bool hasIndexBuffer = false;
@@ -31,7 +44,11 @@ struct Mesh {
     AllocatedBuffer vertexIndexBuffer;
 
     void bind(VkCommandBuffer cmd);
+    void bind(moo::VulkanCommandEncoder& encoder);
     void draw(VkCommandBuffer cmd);
+    void draw(VkCommandBuffer cmd, uint32_t instanceCount, uint32_t firstInstance = 0, uint32_t lod = 0);
+    // before upload: simplified index lists appended to indices
+    void generateLods(uint32_t maxLods = moo::MMeshSimplifier::MAX_LODS);
 };
 
 }   // namespace moo
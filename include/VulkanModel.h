@@ -1,10 +1,15 @@
 #pragma once
 
+#include "MMeshSimplifier.h"
+#include "VulkanCommandEncoder.h"
 #include "VulkanDevice.h"
+#include "VulkanPushConstants.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "glm/mat4x4.hpp"
 #include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
 
 namespace moo {
 
@@ -23,6 +28,8 @@ private:
     bool m_hasIndexBuffer = false;
     VulkanBuffer m_indexBuffer;
     uint32_t m_indexCount;
+    std::vector<MMeshSimplifier::Lod> m_lods;  // ranges of m_indexBuffer, at least LOD 0
+    glm::vec4 m_boundingSphere;
 
 public:
     struct Vertex {
@@ -33,9 +40,26 @@ public:
         static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
     };
 
+    // per-draw object data, pushed instead of written to a buffer
+    struct PushConstants {
+        glm::mat4 transform{1.0f};  // model space -> clip space
+        glm::vec4 color{1.0f};      // multiplies the vertex color
+        // material resources, VulkanBindlessTable indices (UINT32_MAX: none)
+        uint32_t texture = UINT32_MAX;
+        uint32_t buffer = UINT32_MAX;
+        uint32_t padding[2] = {};
+    };
+    using PushBlock = VulkanPushConstantBlock<PushConstants>;
+
     struct Builder { // temporary helper object
         std::vector<Vertex> vertices{};
         std::vector<uint32_t> indices{};
+        std::vector<MMeshSimplifier::Lod> lods{};   // empty: indices are LOD 0
+
+        // xyz center of the bounds, w radius: model space, for culling
+        glm::vec4 getBoundingSphere() const;
+        // simplified index lists appended to indices, all in the model's one index buffer
+        void generateLods(uint32_t maxLods = MMeshSimplifier::MAX_LODS);
     };
 
     VulkanModel(VulkanDevice &device, const Builder &builder);
@@ -45,7 +69,18 @@ public:
     VulkanModel &operator=(const VulkanModel&) = delete;
 
     void bind(VkCommandBuffer cmd);
+    // skipped when the encoder already has these buffers bound
+    void bind(VulkanCommandEncoder &encoder);
     void draw(VkCommandBuffer cmd);
+    // instances [firstInstance, firstInstance + instanceCount): gl_InstanceIndex range
+    void draw(VkCommandBuffer cmd, uint32_t instanceCount, uint32_t firstInstance = 0, uint32_t lod = 0);
+
+    // of LOD 0, 0 without index buffer
+    inline uint32_t getIndexCount() const { return m_hasIndexBuffer ? m_lods[0].indexCount : 0; }
+    // one without index buffer or generated LODs
+    inline const std::vector<MMeshSimplifier::Lod>& getLods() const { return m_lods; }
+    // Builder::getBoundingSphere
+    inline const glm::vec4& getBoundingSphere() const { return m_boundingSphere; }
 
 private:
     void createVertexBuffer(const std::vector<Vertex> &vertices);
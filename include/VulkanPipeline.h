@@ -1,6 +1,10 @@
 #pragma once
 
+#include "VulkanCommandEncoder.h"
 #include "VulkanDevice.h"
+#include "VulkanDynamicState.h"
+#include "VulkanPipelineRegistry.h"
+#include "VulkanSpecialization.h"
 
 #include <string>
 
@@ -10,7 +14,9 @@ class VulkanDevice;
 
 class VulkanPipeline {
 public:
+    // dynamicStateInfo points into dynamicStateEnables: not copyable, share it instead
     struct PipelineConfigInfo {
+        PipelineConfigInfo() = default;
         PipelineConfigInfo(const PipelineConfigInfo&) = delete;
         PipelineConfigInfo& operator=(const PipelineConfigInfo&) = delete;
 
@@ -24,32 +30,52 @@ public:
         std::vector<VkDynamicState> dynamicStateEnables;
         VkPipelineDynamicStateCreateInfo dynamicStateInfo;
 
+        // shader variants without extra SPIR-V: the driver folds the constants
+        VulkanSpecialization vertSpecialization;
+        VulkanSpecialization fragSpecialization;
+
         VkPipelineLayout pipelineLayout = nullptr;
         VkRenderPass renderpass = nullptr;
         uint32_t subpass = 0;
+
+        // render pass attachment formats: pipelines built for a compatible render pass are shared
+        // by the registry (swapchain recreation keeps the formats). Empty = keyed by renderpass handle
+        std::vector<VkFormat> colorAttachmentFormats;
+        VkFormat depthAttachmentFormat = VK_FORMAT_UNDEFINED;
     };
 
 private:
     VulkanDevice& m_device;
+    VulkanPipelineRegistry* m_registry = nullptr;   // set when the pipeline is shared through a registry
 
     VkPipeline m_graphicsPipeline;
-    VkShaderModule m_vertShaderModule, m_fragShaderModule;
 
 public:
     VulkanPipeline(VulkanDevice &device, const std::string &vertFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo);
+    // takes ownership of a pipeline compiled elsewhere (VulkanPipelineCompiler),
+    // with a registry the pipeline is a registry reference released on destruction
+    VulkanPipeline(VulkanDevice &device, VkPipeline pipeline, VulkanPipelineRegistry *registry = nullptr);
+    // identical states share one VkPipeline
+    VulkanPipeline(VulkanDevice &device, VulkanPipelineRegistry &registry, const std::string &vertFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo);
     ~VulkanPipeline();
 
     VulkanPipeline(const VulkanPipeline&) = delete;
     VulkanPipeline& operator=(const VulkanPipeline&) = delete;
 
     static void defaultPipelineConfigInfo(PipelineConfigInfo &configInfo);
+    // cull mode, front face, topology and depth test/write/compare become dynamic (Vulkan 1.3):
+    // the baked values are ignored, set them with VulkanDynamicState while recording
+    static void enableExtendedDynamicState(PipelineConfigInfo &configInfo);
+    // safe to call from any thread. Without registry the caller owns the returned pipeline,
+    // with a registry it holds one reference to release.
+    // Fast/Optimized link through the device pipeline library, monolithic when it isn't supported.
+    // renderpass: used instead of configInfo.renderpass when set, a compatible one
+    static VkPipeline createGraphicsPipeline(VulkanDevice &device, const std::string &vertFilepath, const std::string &fragFilepath,
+        const PipelineConfigInfo &configInfo, VulkanPipelineRegistry *registry = nullptr,
+        VulkanPipelineLibrary::Link link = VulkanPipelineLibrary::Link::Monolithic, VkRenderPass renderpass = VK_NULL_HANDLE);
 
     void bind(VkCommandBuffer commandBuffer);
-    
-private:
-    static std::vector<char> readFile(const std::string &filepath);
-    void createGraphicsPipeline(const std::string &vertFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo);
-    void createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule, const std::string &filepath);
+    void bind(VulkanCommandEncoder &encoder);
 };
 
 }   // namespace moo
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "vk_types.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace moo {
+
+// VkPipelineCache persisted between runs. The driver blob is stored behind our own header
+// (device identity + checksum): a cache written by another GPU, driver or a truncated write
+// is discarded at load instead of being handed to the driver.
+// Saves go to a temporary file renamed over the old one, a crash never leaves half a cache.
+class VulkanPipelineCache {
+public:
+    static constexpr uint32_t FILE_MAGIC = 0x4843504d;      // "MPCH"
+    static constexpr uint32_t FILE_VERSION = 1;
+    static constexpr double DEFAULT_SAVE_INTERVAL = 30.0;   // seconds between periodic saves
+
+    VulkanPipelineCache(VkDevice device, const VkPhysicalDeviceProperties& properties, std::string filepath);
+    ~VulkanPipelineCache();
+
+    VulkanPipelineCache(const VulkanPipelineCache&) = delete;
+    VulkanPipelineCache& operator=(const VulkanPipelineCache&) = delete;
+
+    inline VkPipelineCache getCache() { return m_cache; }
+    inline void setSaveInterval(double seconds) { m_saveInterval = seconds; }
+
+    // writes the cache if it grew since the last save, returns false on I/O failure
+    bool save();
+    // periodic save, cheap to call every frame
+    void saveIfDue();
+
+private:
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+        uint64_t dataSize;
+        uint64_t checksum;      // FNV-1a of the driver blob
+    };
+
+    VkDevice m_device;
+    VkPhysicalDeviceProperties m_properties;
+    std::string m_filepath;
+    VkPipelineCache m_cache = VK_NULL_HANDLE;
+
+    size_t m_savedSize = 0;
+    double m_saveInterval = DEFAULT_SAVE_INTERVAL;
+    std::chrono::steady_clock::time_point m_lastSave;
+
+    // returns the driver blob of a valid cache file, empty when missing or rejected
+    std::vector<char> load();
+    FileHeader makeHeader(const std::vector<char>& data) const;
+
+    static uint64_t checksum(const char* data, size_t size);
+};
+
+}   // namespace moo
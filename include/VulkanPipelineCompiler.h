@@ -0,0 +1,47 @@
+#pragma once
+
+#include "MThreadPool.h"
+#include "VulkanPipeline.h"
+
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace moo {
+
+// Compiles batches of graphics pipelines in parallel on a worker pool.
+// Every worker goes through the device pipeline cache, which is internally
+// synchronized (created without the externally synchronized flag).
+class VulkanPipelineCompiler {
+public:
+    struct Request {
+        std::string vertFilepath;
+        std::string fragFilepath;
+        // shared with the worker: has to stay alive and unchanged until the pipeline is built
+        std::shared_ptr<const VulkanPipeline::PipelineConfigInfo> config;
+        // optional: deduplicate through a registry, the future then yields a registry reference
+        VulkanPipelineRegistry* registry = nullptr;
+        VulkanPipelineLibrary::Link link = VulkanPipelineLibrary::Link::Monolithic;
+        // replaces config->renderpass when set: the config outlives the render pass it was made with
+        VkRenderPass renderpass = VK_NULL_HANDLE;
+    };
+
+    explicit VulkanPipelineCompiler(VulkanDevice& device, uint32_t threadCount = 0);
+
+    VulkanPipelineCompiler(const VulkanPipelineCompiler&) = delete;
+    VulkanPipelineCompiler& operator=(const VulkanPipelineCompiler&) = delete;
+
+    // the caller owns the pipelines, wrap them with VulkanPipeline(device, pipeline)
+    std::future<VkPipeline> compile(Request request);
+    // one future per request, same order
+    std::vector<std::future<VkPipeline>> compile(std::vector<Request> batch);
+
+    inline MThreadPool& getThreadPool() { return m_pool; }
+
+private:
+    VulkanDevice& m_device;
+    MThreadPool m_pool;
+};
+
+}   // namespace moo
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "VulkanPipelineRegistry.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace moo {
+
+// VK_EXT_graphics_pipeline_library: a monolithic create info is split into its four parts
+// (vertex input, pre-rasterization, fragment shader, fragment output). Each part is compiled
+// once per distinct state and shared by every pipeline built from it: a new variant only
+// compiles the parts nobody built yet, then links, which is far cheaper than a full compile.
+// Thread-safe.
+class VulkanPipelineLibrary {
+public:
+    enum class Link {
+        Monolithic,     // full compile, no library
+        Fast,           // parts linked as they are: quick to create, for the first use
+        Optimized,      // link time optimization: draws as fast as monolithic, meant for the background
+    };
+
+    struct Stats {
+        uint32_t parts = 0;
+        uint64_t partHits = 0;
+        uint64_t partMisses = 0;
+        uint64_t links = 0;
+    };
+
+    // supported: the device enabled graphicsPipelineLibrary and links fast,
+    // otherwise link() is not available and callers build monolithic pipelines
+    VulkanPipelineLibrary(VkDevice device, VkPipelineCache cache, bool supported);
+    // the linked pipelines must be destroyed first
+    ~VulkanPipelineLibrary();
+
+    VulkanPipelineLibrary(const VulkanPipelineLibrary&) = delete;
+    VulkanPipelineLibrary& operator=(const VulkanPipelineLibrary&) = delete;
+
+    inline bool isSupported() const { return m_supported; }
+
+    // compiles the missing parts on the calling thread, then links them. The caller owns the pipeline.
+    // With formats, the parts are shared by every compatible render pass
+    VkPipeline link(const VkGraphicsPipelineCreateInfo& pipelineInfo, const VulkanPipelineRegistry::AttachmentFormats* formats = nullptr,
+        bool optimize = false);
+
+    Stats getStats();
+
+private:
+    enum Part : uint32_t {
+        VertexInput,
+        PreRasterization,
+        FragmentShader,
+        FragmentOutput,
+        PartCount
+    };
+
+    VkDevice m_device;
+    VkPipelineCache m_cache;
+    bool m_supported;
+
+    std::mutex m_mutex;
+    std::unordered_map<VulkanPipelineRegistry::StateKey, VkPipeline, VulkanPipelineRegistry::StateKeyHash> m_parts;
+
+    std::atomic<uint64_t> m_partHits {0};
+    std::atomic<uint64_t> m_partMisses {0};
+    std::atomic<uint64_t> m_links {0};
+
+    VkPipeline getPart(Part part, const VkGraphicsPipelineCreateInfo& pipelineInfo, const VulkanPipelineRegistry::AttachmentFormats* formats);
+};
+
+}   // namespace moo
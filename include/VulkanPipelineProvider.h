@@ -0,0 +1,112 @@
+#pragma once
+
+#include "VulkanPipelineCompiler.h"
+#include "VulkanSwapchain.h"
+
+#include <exception>
+#include <future>
+#include <limits>
+#include <vector>
+
+namespace moo {
+
+// Lazily compiled pipelines: the first get() of a variant queues it on the compiler and
+// returns right away, draws use the fallback (or are skipped) until the pipeline is ready.
+// A new variant never stalls the frame. Render thread only, the compiler does the threading.
+// With graphics pipeline libraries the variant is first fast-linked from shared parts, then
+// swapped for its link time optimized version compiled in the background.
+class VulkanPipelineProvider {
+public:
+    using Handle = uint32_t;
+    static constexpr Handle INVALID_HANDLE = std::numeric_limits<Handle>::max();
+
+    struct Stats {
+        uint32_t variants = 0;
+        uint32_t pending = 0;           // queued, not compiled yet
+        uint32_t ready = 0;
+        uint64_t fallbackDraws = 0;     // get() answered with the fallback
+        uint64_t skippedDraws = 0;      // get() answered VK_NULL_HANDLE
+        uint32_t maxPendingFrames = 0;  // frames between the first request and the first use
+        uint64_t totalPendingFrames = 0;
+        uint32_t optimized = 0;         // fast links swapped for the optimized pipeline
+    };
+
+    // a swapped out pipeline may still be in flight: released after this many frames
+    static constexpr uint64_t RETIRE_FRAMES = VulkanSwapchain::MAX_FRAMES_IN_FLIGHT + 1;
+
+    VulkanPipelineProvider(VulkanDevice& device, VulkanPipelineCompiler& compiler);
+    // waits for the compiles in flight, then releases every pipeline: the GPU must be idle
+    ~VulkanPipelineProvider();
+
+    VulkanPipelineProvider(const VulkanPipelineProvider&) = delete;
+    VulkanPipelineProvider& operator=(const VulkanPipelineProvider&) = delete;
+
+    // registers a variant, nothing is compiled before the first get()
+    Handle add(VulkanPipelineCompiler::Request request);
+    // new state for a variant (e.g. incompatible render pass): the current pipeline is released,
+    // it must not be in use anymore. The next get() compiles again
+    void replace(Handle handle, VulkanPipelineCompiler::Request request);
+    // drawn while another variant compiles, INVALID_HANDLE = skip those draws.
+    // The fallback itself is compiled right away, waited for on its first get()
+    void setFallback(Handle handle);
+
+    // never blocks, except for the fallback's first compile. The pipeline if ready,
+    // else the fallback's or VK_NULL_HANDLE. A failed compile rethrows here, on every get() until replaced
+    VkPipeline get(Handle handle);
+
+    // blocks until every queued or running compile is done (results are picked up by get() as usual).
+    // Workers can't be cancelled: call it before destroying the render pass the variants were built for
+    void waitForCompiles();
+    // compatible render pass for every later compile (swapchain recreation), after waitForCompiles.
+    // Pipelines already built keep working with it
+    void setRenderPass(VkRenderPass renderpass);
+
+    // frame counter of the pending stats, once per frame before recording
+    void beginFrame();
+    bool hasPending() const;
+
+    // frames the variant went without its pipeline (fallback or skipped), 0 while still pending
+    uint32_t getPendingFrames(Handle handle) const;
+    inline const Stats& getStats() const { return m_stats; }
+
+private:
+    struct Variant {
+        VulkanPipelineCompiler::Request request;
+        std::future<VkPipeline> compile;
+        std::future<VkPipeline> optimize;   // background link time optimization of a fast link
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        std::exception_ptr error;
+        uint64_t requestFrame = 0;
+        uint32_t pendingFrames = 0;
+    };
+
+    // compiles dropped by replace() before they finished and swapped out fast links,
+    // released once done and no longer in flight
+    struct Retired {
+        std::future<VkPipeline> compile;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VulkanPipelineRegistry* registry = nullptr;
+        uint64_t releaseFrame = 0;
+    };
+
+    VulkanDevice& m_device;
+    VulkanPipelineCompiler& m_compiler;
+
+    std::vector<Variant> m_variants;
+    std::vector<Retired> m_retired;
+    Handle m_fallback = INVALID_HANDLE;
+    bool m_linkLibraries;
+
+    uint64_t m_frame = 0;
+    Stats m_stats{};
+
+    void request(Variant& variant);
+    bool poll(Variant& variant);
+    void pollOptimized(Variant& variant);
+    void retire(std::future<VkPipeline> compile, VulkanPipelineRegistry* registry);
+    VkPipeline resolve(Handle handle);
+    void releasePipeline(VkPipeline pipeline, VulkanPipelineRegistry* registry);
+    void collectRetired(bool wait);
+};
+
+}   // namespace moo
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "vk_types.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace moo {
+
+class VulkanPipelineLibrary;
+
+// Deduplicates graphics pipelines: the complete create info (shader stages, vertex layout,
+// every fixed-function state, dynamic states, layout, attachment formats) is canonicalized
+// into a key, its bytes and their 64 bit hash. Identical requests share one VkPipeline, refcounted.
+// Works for both builders, VulkanPipeline::PipelineConfigInfo and mii::PipelineBuilder,
+// since both end up in a VkGraphicsPipelineCreateInfo. Thread-safe.
+class VulkanPipelineRegistry {
+public:
+    // render pass compatibility: with formats given, any compatible render pass
+    // (e.g. the one recreated with the swapchain) hits the same pipeline
+    struct AttachmentFormats {
+        std::vector<VkFormat> color;
+        VkFormat depth = VK_FORMAT_UNDEFINED;
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    };
+
+    // the hash picks the bucket, the bytes decide: a hash collision is a miss, not another state's pipeline
+    struct StateKey {
+        uint64_t hash = 14695981039346656037ULL;
+        std::vector<uint8_t> bytes;
+
+        // keys the same state apart by use (library part, link mode)
+        void addTag(uint32_t tag);
+        inline bool operator==(const StateKey& other) const { return hash == other.hash && bytes == other.bytes; }
+    };
+
+    struct StateKeyHash {
+        inline size_t operator()(const StateKey& key) const { return static_cast<size_t>(key.hash); }
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint32_t pipelines = 0;     // alive, i.e. referenced at least once
+    };
+
+    VulkanPipelineRegistry(VkDevice device, VkPipelineCache cache);
+    ~VulkanPipelineRegistry();
+
+    VulkanPipelineRegistry(const VulkanPipelineRegistry&) = delete;
+    VulkanPipelineRegistry& operator=(const VulkanPipelineRegistry&) = delete;
+
+    // returns a referenced pipeline, compiled on a miss. Every acquire needs a release.
+    // With a supported library the miss links library parts instead (optimize: link time optimization),
+    // linked pipelines are keyed apart from monolithic ones
+    VkPipeline acquire(const VkGraphicsPipelineCreateInfo& pipelineInfo, const AttachmentFormats* formats = nullptr,
+        VulkanPipelineLibrary* library = nullptr, bool optimize = false);
+    // the last release destroys the pipeline: the GPU must be done with it, as for vkDestroyPipeline
+    void release(VkPipeline pipeline);
+
+    Stats getStats();
+
+    // shader modules are hashed by handle: the shader cache already gives identical
+    // SPIR-V one module. Inline modules (VkShaderModuleCreateInfo in pNext) hash the code
+    static StateKey makeKey(const VkGraphicsPipelineCreateInfo& pipelineInfo, const AttachmentFormats* formats);
+
+private:
+    struct Entry {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        uint32_t references = 0;
+    };
+
+    VkDevice m_device;
+    VkPipelineCache m_cache;
+
+    std::mutex m_mutex;
+    std::unordered_map<StateKey, Entry, StateKeyHash> m_entries;
+    std::unordered_map<VkPipeline, StateKey> m_keys;
+
+    std::atomic<uint64_t> m_hits {0};
+    std::atomic<uint64_t> m_misses {0};
+};
+
+}   // namespace moo
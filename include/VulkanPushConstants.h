@@ -0,0 +1,31 @@
+#pragma once
+
+#include "vk_types.h"
+
+#include <cstdint>
+#include <type_traits>
+
+namespace moo {
+
+// maxPushConstantsSize every device supports
+constexpr uint32_t GUARANTEED_PUSH_CONSTANTS_SIZE = 128;
+
+// Per-draw data pushed straight into the command buffer, no descriptor or buffer update.
+// T is the plain struct mirroring the shader's push_constant block (std430 rules: mind vec3).
+// Its range goes into the pipeline layout (VulkanLayoutCache::getLayout), values are recorded
+// with VulkanCommandEncoder::push<Block>(layout, value).
+template <typename T, VkShaderStageFlags Stages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, uint32_t Offset = 0>
+struct VulkanPushConstantBlock {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T>, "push constant blocks are plain structs");
+    static_assert(sizeof(T) % 4 == 0 && Offset % 4 == 0, "push constant offset and size are multiples of 4");
+    static_assert(Offset + sizeof(T) <= GUARANTEED_PUSH_CONSTANTS_SIZE, "push constant block larger than what every device supports");
+
+    using Type = T;
+    static constexpr VkShaderStageFlags STAGES = Stages;
+    static constexpr uint32_t OFFSET = Offset;
+    static constexpr uint32_t SIZE = static_cast<uint32_t>(sizeof(T));
+
+    static constexpr VkPushConstantRange range() { return VkPushConstantRange{Stages, Offset, SIZE}; }
+};
+
+}   // namespace moo
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "VulkanModel.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace moo {
+
+// Draws collected for a frame, sorted, then recorded with as few state changes as possible.
+// Each draw carries a 64-bit key, most significant field first:
+//   pass 4 | pipeline 12 | material 16 | mesh 16 | depth 16
+// so after sorting, draws sharing a pipeline, then a material, then a mesh are adjacent. submit()
+// records them through a VulkanCommandEncoder, which binds the pipeline, the material set and the
+// mesh buffers only when they differ from the previous draw's. Sorting is an LSD radix sort
+// on the keys, stable: equal keys keep their push order. Storage is reused frame to frame, no
+// allocation once warm.
+class VulkanRenderQueue {
+public:
+    static constexpr uint32_t PASS_BITS = 4;
+    static constexpr uint32_t PIPELINE_BITS = 12;
+    static constexpr uint32_t MATERIAL_BITS = 16;
+    static constexpr uint32_t MESH_BITS = 16;
+    static constexpr uint32_t DEPTH_BITS = 16;
+
+    struct Draw {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        uint32_t dynamicStates = 0;                 // VulkanCommandEncoder::DynamicStates of pipeline
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        VkDescriptorSet material = VK_NULL_HANDLE;  // bound at set 0, VK_NULL_HANDLE: none (bindless: constants indices)
+        VulkanModel* model = nullptr;
+        uint32_t instanceCount = 1;
+        uint32_t firstInstance = 0;
+        uint32_t lod = 0;                           // of model, MMeshSimplifier::selectLod
+        bool pushConstants = false;                 // layout has VulkanModel::PushBlock's range
+        VulkanModel::PushConstants constants{};
+    };
+
+    // ids are the caller's small integers (pipeline provider handle, material index...),
+    // truncated to their field. depth: a quantizeDepth() value
+    static uint64_t makeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, uint16_t depth);
+    // depth in [0, 1]: front to back for opaque draws (fewer overdrawn fragments),
+    // back to front for blended ones
+    static uint16_t quantizeDepth(float depth, bool backToFront = false);
+
+    void clear();
+    void reserve(size_t drawCount);
+    void push(uint64_t key, const Draw &draw);
+
+    void sort();
+    // inside the render pass: walks the sorted draws
+    void submit(VulkanCommandEncoder &encoder);
+
+    inline size_t size() const { return m_entries.size(); }
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t draw;      // index in m_draws
+    };
+
+    std::vector<Draw> m_draws;
+    std::vector<Entry> m_entries;
+    std::vector<Entry> m_scratch;   // radix sort ping-pong
+};
+
+}   // namespace moo
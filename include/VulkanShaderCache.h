@@ -0,0 +1,65 @@
+#pragma once
+
+#include "MFileMapping.h"
+#include "VulkanShaderReflection.h"
+#include "vk_types.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace moo {
+
+// Registry of SPIR-V shaders: each file is memory mapped and hashed once, identical
+// contents share one entry and the VkShaderModule lives as long as the registry.
+// Pipeline rebuilds (every resize) only do a path lookup, never touch the filesystem.
+// With inline modules (VK_KHR_maintenance5) no VkShaderModule is created: the stage
+// chains a VkShaderModuleCreateInfo pointing into the mapped file instead.
+// The interface is reflected on load too, layouts are built from it (VulkanLayoutCache).
+// Thread-safe: pipelines can be built from worker threads.
+class VulkanShaderCache {
+public:
+    VulkanShaderCache(VkDevice device, bool inlineModules);
+    ~VulkanShaderCache();
+
+    VulkanShaderCache(const VulkanShaderCache&) = delete;
+    VulkanShaderCache& operator=(const VulkanShaderCache&) = delete;
+
+    // the registry owns the module, callers must not destroy it
+    VkShaderModule getModule(const std::string& filepath);
+    // stage ready for VkGraphicsPipelineCreateInfo, valid as long as the registry
+    VkPipelineShaderStageCreateInfo getStageInfo(const std::string& filepath, VkShaderStageFlagBits stage);
+    // content hash of a loaded shader, usable as a pipeline key
+    uint64_t getHash(const std::string& filepath);
+    // valid as long as the registry
+    const VulkanShaderReflection& getReflection(const std::string& filepath);
+
+    inline bool usesInlineModules() const { return m_inlineModules; }
+
+private:
+    struct Entry {
+        MFileMapping file;
+        uint64_t hash = 0;
+        VkShaderModuleCreateInfo createInfo {};
+        VkShaderModule module = VK_NULL_HANDLE;
+        std::unique_ptr<VulkanShaderReflection> reflection;
+    };
+
+    VkDevice m_device;
+    bool m_inlineModules;
+
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<Entry>> m_entries;
+    std::unordered_map<std::string, Entry*> m_byPath;
+    std::unordered_map<uint64_t, Entry*> m_byHash;
+
+    // both expect m_mutex to be held
+    Entry& load(const std::string& filepath);
+    VkShaderModule createModule(Entry& entry, const std::string& filepath);
+
+    static uint64_t hashCode(const void* data, size_t size);
+};
+
+}   // namespace moo
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "vk_types.h"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace moo {
+
+// Interface of a SPIR-V module read straight from its words: descriptor bindings, push
+// constant block, vertex inputs and compute local size. Done once per shader when it is
+// loaded (VulkanShaderCache), layouts are then built from it instead of written by hand.
+// Only the first entry point is reflected.
+class VulkanShaderReflection {
+public:
+    struct DescriptorBinding {
+        uint32_t set = 0;
+        uint32_t binding = 0;
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        uint32_t count = 1;                 // array size, 0 = runtime array
+        VkShaderStageFlags stages = 0;
+    };
+
+    struct VertexInput {
+        uint32_t location = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+    };
+
+    // throws when the words are not a SPIR-V module
+    VulkanShaderReflection(const uint32_t* code, size_t wordCount);
+
+    inline VkShaderStageFlagBits getStage() const { return m_stage; }
+    // sorted by set, then binding
+    inline const std::vector<DescriptorBinding>& getBindings() const { return m_bindings; }
+    // size 0: no push constants
+    inline const VkPushConstantRange& getPushConstantRange() const { return m_pushConstants; }
+    // vertex stage only, sorted by location. A matrix takes one location per column
+    inline const std::vector<VertexInput>& getVertexInputs() const { return m_vertexInputs; }
+    // compute stage only, {1, 1, 1} when set by specialization constants
+    inline const std::array<uint32_t, 3>& getLocalSize() const { return m_localSize; }
+
+    // tightly packed, in location order, for shaders reading one interleaved binding
+    std::vector<VkVertexInputAttributeDescription> getVertexAttributes(uint32_t binding, uint32_t* stride = nullptr) const;
+    // every vertex input has an attribute of the same format (hand-written descriptions)
+    bool matchesVertexAttributes(const std::vector<VkVertexInputAttributeDescription>& attributes) const;
+
+    static uint32_t formatSize(VkFormat format);
+
+private:
+    VkShaderStageFlagBits m_stage = VK_SHADER_STAGE_VERTEX_BIT;
+    std::vector<DescriptorBinding> m_bindings;
+    VkPushConstantRange m_pushConstants {};
+    std::vector<VertexInput> m_vertexInputs;
+    std::array<uint32_t, 3> m_localSize {1, 1, 1};
+};
+
+}   // namespace moo
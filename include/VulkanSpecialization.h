@@ -0,0 +1,46 @@
+#pragma once
+
+#include "vk_types.h"
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace moo {
+
+// Typed specialization constants of one shader stage (constant_id -> value).
+// Entries are kept sorted by constant ID with tightly packed data, so the same set of
+// values always gives the same VkSpecializationInfo bytes, whatever order they were set in:
+// the pipeline registry hashes them, identical variants stay one pipeline.
+class VulkanSpecialization {
+public:
+    // bool becomes a VkBool32, as SPIR-V boolean constants expect
+    template <typename T>
+    VulkanSpecialization& set(uint32_t constantID, T value) {
+        static_assert(std::is_same_v<T, bool> || std::is_same_v<T, int32_t> || std::is_same_v<T, uint32_t> ||
+            std::is_same_v<T, float> || std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t> || std::is_same_v<T, double>,
+            "specialization constants are bool, 32/64 bit integers or floats");
+
+        if constexpr (std::is_same_v<T, bool>) {
+            VkBool32 boolValue = value ? VK_TRUE : VK_FALSE;
+            setBytes(constantID, &boolValue, sizeof(boolValue));
+        } else {
+            setBytes(constantID, &value, sizeof(value));
+        }
+        return *this;
+    }
+
+    void clear();
+    inline bool empty() const { return m_entries.empty(); }
+
+    // points into this object: valid while it lives unchanged
+    VkSpecializationInfo getInfo() const;
+
+private:
+    std::vector<VkSpecializationMapEntry> m_entries;
+    std::vector<uint8_t> m_data;
+
+    void setBytes(uint32_t constantID, const void* value, size_t size);
+};
+
+}   // namespace moo
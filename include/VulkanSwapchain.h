@@ -1,6 +1,7 @@
 #pragma once
 
 #include "VulkanDevice.h"
+#include "MFrameStats.h"
 
 #include <memory>
 
@@ -34,6 +35,9 @@ public:
     VkResult acquireNextImage(uint32_t *imageIndex);
     VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
 
+    // time spent blocked on fences, acquire and present goes to stats, nullptr disables it
+    void setFrameStats(MFrameStats *stats) { m_frameStats = stats; }
+
 private:
     VkFormat m_swapChainImageFormat;
     VkExtent2D m_swapChainExtent;
@@ -59,6 +63,8 @@ private:
     std::vector<VkFence> imagesInFlight;
     size_t currentFrame = 0;
 
+    MFrameStats *m_frameStats = nullptr;
+
     void init();
     void createSwapChain();
     void createImageViews();
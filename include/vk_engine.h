@@ -1,12 +1,22 @@
 ﻿#pragma once
 
 #include "MWindow.h"
+#include "MFrameStats.h"
+#include "VulkanBindlessTable.h"
+#include "VulkanCommandEncoder.h"
 #include "VulkanDebug.h"
+#include "VulkanDescriptorAllocator.h"
+#include "VulkanDynamicState.h"
+#include "VulkanLayoutCache.h"
 #include "VulkanMesh.h"
+#include "VulkanPipelineCache.h"
+#include "VulkanPipelineRegistry.h"
+#include "VulkanShaderCache.h"
 
 #include <functional>
 #include <deque>
 #include <array>
+#include <memory>
 #include <optional>
 
 namespace mii {
@@ -14,6 +24,9 @@ namespace mii {
 constexpr unsigned int MAX_FRAMES_IN_FLIGHT = 2; // number of frames to overlap when rendering
 constexpr int WIDTH = 640;
 constexpr int HEIGHT = 360;
+constexpr int IDLE_WAIT_TIMEOUT_MS = 250; // upper bound of a blocking event wait when nothing has to be drawn
+constexpr const char* PIPELINE_CACHE_FILE = "pipeline_cache_old.bin";
+constexpr bool BINDLESS = false; // textures and buffers indexed from one set bound per frame, when the GPU has descriptor indexing
 
 struct DeletionQueue {
 	std::deque<std::function<void()>> deletors;
@@ -102,6 +115,7 @@ private:
 	bool m_initialized = false;
 
 	moo::MWindow m_window {"Amazing Mopugno", WIDTH, HEIGHT};
+	moo::MFrameStats m_frameStats {};
 
 	VkInstance m_instance;
 	moo::VulkanDebug m_debugger;
@@ -131,6 +145,15 @@ private:
 	VkRenderPass m_renderPass;
 	VkPipelineLayout m_defaultPipeLayout;
 	VkPipeline m_defaultGraphicsPipeline;
+	moo::VulkanCommandEncoder m_encoder; // skips redundant binds and dynamic state
+	bool m_extendedDynamicState = false; // m_defaultGraphicsPipeline sets raster/depth state while recording
+	std::unique_ptr<moo::VulkanPipelineCache> m_pipelineCache;
+	std::unique_ptr<moo::VulkanShaderCache> m_shaderCache;
+	std::unique_ptr<moo::VulkanLayoutCache> m_layoutCache; // owns m_defaultPipeLayout
+	std::unique_ptr<moo::VulkanDescriptorAllocator> m_descriptors; // transient sets, one slot per frame in flight
+	moo::VulkanBindlessTable::Capacity m_bindlessCapacity {}; // features enabled by createLogicalDevice
+	std::unique_ptr<moo::VulkanBindlessTable> m_bindless; // BINDLESS: set 0 of m_defaultPipeLayout
+	std::unique_ptr<moo::VulkanPipelineRegistry> m_pipelineRegistry; // owns m_defaultGraphicsPipeline
 
 	std::array<FrameData, MAX_FRAMES_IN_FLIGHT> m_frames;
 	inline FrameData& get_current_frame() { return m_frames[m_frameNumber % MAX_FRAMES_IN_FLIGHT]; }
@@ -7,7 +7,7 @@
 
 namespace vkinit {
 	//vulkan init code goes here
-	VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfo(VkShaderStageFlagBits stage, VkShaderModule shaderModule);
+	VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfo(VkShaderStageFlagBits stage, VkShaderModule shaderModule, const VkSpecializationInfo* specializationInfo = nullptr);
 	VkPipelineVertexInputStateCreateInfo pipelineVertexInputCreateInfo();
 	VkPipelineInputAssemblyStateCreateInfo pipeInputAssemblyCreateInfo(VkPrimitiveTopology topology, VkBool32 primitive = VK_FALSE);
     VkPipelineRasterizationStateCreateInfo rasterizationStageCreateInfo(VkPolygonMode polygonMode);
@@ -30,4 +30,10 @@ namespace vkinit {
     VkSemaphoreCreateInfo semaphoreCreateInfo(VkSemaphoreCreateFlags flags = 0);
 	VkSubmitInfo submitInfo(const VkCommandBuffer* cmd);
 	VkPresentInfoKHR presentInfo();
+
+	// compute
+	VkComputePipelineCreateInfo computePipelineCreateInfo(const VkPipelineShaderStageCreateInfo& stage, VkPipelineLayout layout);
+	VkDescriptorSetLayoutBinding descriptorSetLayoutBinding(VkDescriptorType type, VkShaderStageFlags stageFlags, uint32_t binding);
+	VkWriteDescriptorSet writeDescriptorBuffer(VkDescriptorType type, VkDescriptorSet dstSet, const VkDescriptorBufferInfo* bufferInfo, uint32_t binding);
+	VkBufferMemoryBarrier bufferMemoryBarrier(VkBuffer buffer, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
 }
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <map>
 #include <vector>
 
 #include "vk_types.h"
+#include "VulkanPipelineRegistry.h"
+#include "VulkanSpecialization.h"
 
 namespace mii {
 
@@ -18,9 +21,31 @@ public:
     VkPipelineColorBlendAttachmentState colorBlendAttachment;
     VkPipelineDynamicStateCreateInfo dynamicStateInfo;
     VkPipelineLayout pipelineLayout;
+    // per stage constant_id values, applied to the matching shaderStages at build time
+    std::map<VkShaderStageFlagBits, moo::VulkanSpecialization> specializations;
 
 public:
-    VkPipeline build_pipeline(VkDevice device, VkRenderPass renderpass);
+    template <typename T>
+    PipelineBuilder& set_specialization(VkShaderStageFlagBits stage, uint32_t constantID, T value) {
+        specializations[stage].set(constantID, value);
+        return *this;
+    }
+
+    // cache may be VK_NULL_HANDLE, every pipeline is then compiled from scratch
+    VkPipeline build_pipeline(VkDevice device, VkRenderPass renderpass, VkPipelineCache cache = VK_NULL_HANDLE) const;
+    // shared through the registry (compiled with its cache): release the pipeline to the registry, not vkDestroyPipeline
+    VkPipeline build_pipeline(moo::VulkanPipelineRegistry& registry, VkRenderPass renderpass,
+        const moo::VulkanPipelineRegistry::AttachmentFormats* formats = nullptr) const;
+
+private:
+    // storage the create info points to
+    struct CreateState {
+        VkPipelineColorBlendStateCreateInfo colorBlending;
+        std::vector<VkPipelineShaderStageCreateInfo> stages;
+        std::vector<VkSpecializationInfo> specializationInfos;
+    };
+
+    VkGraphicsPipelineCreateInfo fill_create_info(VkRenderPass renderpass, CreateState& state) const;
 };
 
 }   // namespace mii
\ No newline at end of file
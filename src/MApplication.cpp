@@ -1,70 +1,268 @@
 #include "MApplication.h"
 
 #include "vk_initializers.h"
+#include "MLogger.h"
+
+#include "glm/gtc/matrix_transform.hpp"
 
 #include <stdexcept>
+#include <algorithm>
 #include <array>
 #include <cassert>
-#include <iostream>
+#include <chrono>
 
 using namespace moo;
 
 MApplication::MApplication() {
+    // diagnostics only: without the file the title overlay still shows the stats
+    if (!m_frameStats.setReportFile(FRAME_STATS_FILE)) {
+        MOO_LOG_WARNING("Failed to open frame statistics file %s, CSV export disabled.", FRAME_STATS_FILE);
+    }
+
     loadModels();
 
     createPipelineLayout();
     reCreateSwapchain(); //createPipeline();
     createCommandBuffers();
+
+    m_window.setRedrawInterval(REDRAW_INTERVAL_MS);
 }
 
 MApplication::~MApplication() {
-    vkDestroyPipelineLayout(m_device.getDevice(), m_pipelineLayout, nullptr);
+    // compiles still queued or running read the swapchain's render pass: done before it goes
+    m_pipelines.waitForCompiles();
+    m_swapchain.reset();
+    destroyTimestampQueryPool();
 }
 
 void MApplication::run() {
-    SDL_Event e;
+    m_window.setEventListener([this](const SDL_Event& event) { forwardEvent(event); });
+    m_renderThread = std::thread(&MApplication::renderLoop, this);
 
+    // SDL wants events pumped on the thread that created the window: this thread
+    // only handles events, so input stays responsive whatever the renderer is doing
     while (!m_window.isClosing())
     {
-        while (SDL_PollEvent(&e) != 0)
-        {
-            m_window.handleEvent(e);
-        }
-        
-        if(!m_window.isMinimized()) 
+        m_window.processEvents(true, IDLE_WAIT_TIMEOUT_MS);
+    }
+
+    wakeRenderThread();
+    m_renderThread.join();
+    m_window.setEventListener(nullptr);
+
+    vkDeviceWaitIdle(m_device.getDevice());
+
+    if (m_droppedEvents > 0) {
+        MOO_LOG_WARNING("%llu window events dropped: render thread event queue full", static_cast<unsigned long long>(m_droppedEvents.load()));
+    }
+
+    if (m_renderError) {
+        std::rethrow_exception(m_renderError);
+    }
+}
+
+void MApplication::renderLoop() {
+    try {
+        while (!m_window.isClosing())
         {
+            SDL_Event event;
+            while (m_eventQueue.pop(event)) {
+                handleRenderEvent(event);
+            }
+
+            // a dropped resize event still shows up in drawFrame through wasWindowResized
+            if (m_swapchainOutdated && !m_window.isMinimized()) {
+                m_swapchainOutdated = false;
+                m_window.resetWindowResizedFlag();
+                reCreateSwapchain();
+            }
+
+            // the simulation runs on its own clock, drawn or not: an idle frame
+            // (minimized or unchanged scene) still runs the steps that are due
+            bool idle = m_window.isMinimized() || !m_window.needsRedraw();
+
+            // unless no step can change anything: sleep until an event or the timeout,
+            // and resume without catching up on the time spent idle
+            if (idle && isSimulationStatic()) {
+                waitForRenderWake(std::chrono::milliseconds(IDLE_WAIT_TIMEOUT_MS));
+                m_scheduler.reset();
+                continue;
+            }
+
+            MLoopScheduler::Tick tick = m_scheduler.advance(!idle);
+            for (uint32_t i = 0; i < tick.updates; i++) {
+                update(m_scheduler.getStepSeconds());
+            }
+
+            // nothing to draw: sleep until the next step, or until the event thread
+            // forwards input, a resize or a redraw timer tick. A step that moved
+            // something requested a redraw, drawn on the next iteration
+            if (idle) {
+                if (m_window.isMinimized() || !m_window.needsRedraw()) {
+                    waitForRenderWake(std::min<MLoopScheduler::Clock::duration>(m_scheduler.timeUntilNextUpdate(),
+                        std::chrono::milliseconds(IDLE_WAIT_TIMEOUT_MS)));
+                }
+                continue;
+            }
+
+            // render cap: the redraw stays pending until the next frame slot
+            if (!tick.render) {
+                waitForRenderWake(std::min(m_scheduler.timeUntilNextFrame(), m_scheduler.timeUntilNextUpdate()));
+                continue;
+            }
+
+            m_window.resetRedrawRequest();
+            interpolateState(tick.alpha);
+
+            m_frameStats.beginFrame();
+            m_pipelines.beginFrame();
             drawFrame();
+            // keep frames coming until the queued pipelines show up
+            if (m_pipelines.hasPending()) {
+                m_window.requestRedraw();
+            }
+            if (m_frameStats.endFrame()) {
+                m_window.setTitleOverlay(m_frameStats.getSummary());
+                MOO_LOG_DEBUG("%s", m_frameStats.getSummary().c_str());
+
+                const VulkanPipelineRegistry::Stats pipelineStats = m_pipelineRegistry.getStats();
+                MOO_LOG_DEBUG("pipelines: %u alive, %llu hits, %llu misses", pipelineStats.pipelines,
+                    static_cast<unsigned long long>(pipelineStats.hits), static_cast<unsigned long long>(pipelineStats.misses));
+
+                const VulkanPipelineProvider::Stats& variantStats = m_pipelines.getStats();
+                MOO_LOG_DEBUG("pipeline variants: %u ready (%u optimized), %u pending, %llu fallback draws, %llu skipped draws, max %u frames pending",
+                    variantStats.ready, variantStats.optimized, variantStats.pending, static_cast<unsigned long long>(variantStats.fallbackDraws),
+                    static_cast<unsigned long long>(variantStats.skippedDraws), variantStats.maxPendingFrames);
+            }
+
+            // pipelines compiled since the last save survive a crash
+            m_device.getPipelineCache().saveIfDue();
         }
+    } catch (...) {
+        // handed over to the main thread, rethrown from run()
+        m_renderError = std::current_exception();
+        m_window.requestClose();
     }
+}
 
-    vkDeviceWaitIdle(m_device.getDevice());
+void MApplication::forwardEvent(const SDL_Event& event) {
+    // never block the event thread: a full queue drops the event, window state
+    // (extent, minimized, redraw) is already updated by MWindow
+    if (!m_eventQueue.push(event)) {
+        m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    wakeRenderThread();
 }
 
-void MApplication::createPipelineLayout() {
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo = vkinit::pipelineLayoutCreateInfo();
+void MApplication::wakeRenderThread() {
+    {
+        std::lock_guard<std::mutex> lock(m_renderWakeMutex);
+        m_renderWakePending = true;
+    }
+    m_renderWake.notify_one();
+}
+
+void MApplication::waitForRenderWake(std::chrono::steady_clock::duration timeout) {
+    std::unique_lock<std::mutex> lock(m_renderWakeMutex);
+    m_renderWake.wait_for(lock, timeout, [this] { return m_renderWakePending; });
+    m_renderWakePending = false;
+}
+
+void MApplication::update(double dt) {
+    m_previousState = m_currentState;
+    m_currentState.time += dt;
+    m_currentState.angle += SPIN_SPEED * static_cast<float>(dt);
 
-    if(vkCreatePipelineLayout(m_device.getDevice(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to create pipeline layout.");
+    // a static scene is not redrawn, a moving one asks for the frames that show it
+    if (m_currentState.angle != m_previousState.angle) {
+        m_window.requestRedraw();
     }
 }
 
+void MApplication::interpolateState(float alpha) {
+    m_renderState.time = m_previousState.time + (m_currentState.time - m_previousState.time) * alpha;
+    m_renderState.angle = m_previousState.angle + (m_currentState.angle - m_previousState.angle) * alpha;
+}
+
+void MApplication::handleRenderEvent(const SDL_Event& event) {
+    // redraw requests and the extent are already in MWindow's atomic state
+    if (event.type != SDL_WINDOWEVENT) {
+        return;
+    }
+
+    switch (event.window.event)
+    {
+    case SDL_WINDOWEVENT_RESIZED:
+        // a drag sends many: one recreation once the queue is drained,
+        // the first frame at the new size doesn't go through VK_ERROR_OUT_OF_DATE_KHR
+        m_swapchainOutdated = true;
+        break;
+    case SDL_WINDOWEVENT_MINIMIZED:
+        // nothing is drawn until restored, and a minimized window is often closed from outside
+        m_device.getPipelineCache().save();
+        break;
+
+    default:
+        break;
+    }
+}
+
+void MApplication::createPipelineLayout() {
+    // bindless shaders declare runtime arrays, not reflected: the table's set is the only one
+    if constexpr (BINDLESS) {
+        VulkanBindlessTable::Capacity capacity = m_device.getBindlessCapacity();
+        if (capacity.textures > 0 && capacity.buffers > 0) {
+            m_bindless = std::make_unique<VulkanBindlessTable>(m_device.getDevice(), capacity, VulkanSwapchain::MAX_FRAMES_IN_FLIGHT);
+            m_pipelineLayout = m_device.getLayoutCache().getPipelineLayout({m_bindless->getSetLayout()}, VulkanModel::PushBlock::range());
+            return;
+        }
+        MOO_LOG_WARNING("Descriptor indexing not supported, bindless resources disabled.");
+    }
+
+    // reflected from the shaders: any pipeline with the same interface gets this layout
+    VulkanShaderCache& shaders = m_device.getShaderCache();
+    // per-object data is pushed: the range is there even if the shaders don't read it yet
+    VulkanLayoutCache::Layout layout = m_device.getLayoutCache().getLayout({&shaders.getReflection(VERT_SHADER_FILE), &shaders.getReflection(FRAG_SHADER_FILE)},
+        VulkanModel::PushBlock::range());
+    m_pipelineLayout = layout.pipelineLayout;
+}
+
 void MApplication::createPipeline() {
     assert(m_swapchain != nullptr && "Cannot create pipeline before swapchain.");
     assert(m_pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout.");
 
-    VulkanPipeline::PipelineConfigInfo pipelineConfig {};
-    VulkanPipeline::defaultPipelineConfigInfo(pipelineConfig);
+    auto pipelineConfig = std::make_shared<VulkanPipeline::PipelineConfigInfo>();
+    VulkanPipeline::defaultPipelineConfigInfo(*pipelineConfig);
     
-    pipelineConfig.renderpass = m_swapchain->getRenderPass();
-    pipelineConfig.pipelineLayout = m_pipelineLayout;
+    pipelineConfig->renderpass = m_swapchain->getRenderPass();
+    pipelineConfig->pipelineLayout = m_pipelineLayout;
+    // the recreated swapchain keeps its format: a resize hits the registry instead of recompiling
+    pipelineConfig->colorAttachmentFormats = {m_swapchain->getSwapChainImageFormat()};
+
+    // one pipeline for every cull/topology/depth combination
+    m_extendedDynamicState = EXTENDED_DYNAMIC_STATE && VulkanDynamicState::isSupported(m_device.m_deviceProperties);
+    if (m_extendedDynamicState) {
+        VulkanPipeline::enableExtendedDynamicState(*pipelineConfig);
+    }
+    m_pipelineDynamicStates = VulkanCommandEncoder::dynamicStatesOf(pipelineConfig->dynamicStateEnables);
     
-    m_pipeline = std::make_unique<VulkanPipeline>(m_device, "./../shaders/shader.vert.spv", "./../shaders/shader.frag.spv", pipelineConfig);
+    // compiled in the background on first use, the frames before skip the draw
+    VulkanPipelineCompiler::Request request {VERT_SHADER_FILE, FRAG_SHADER_FILE, pipelineConfig, &m_pipelineRegistry};
+    if (m_pipeline == VulkanPipelineProvider::INVALID_HANDLE) {
+        m_pipeline = m_pipelines.add(std::move(request));
+    } else {
+        m_pipelines.replace(m_pipeline, std::move(request));
+    }
+    m_pipelineFormat = m_swapchain->getSwapChainImageFormat();
 }
 
 void MApplication::reCreateSwapchain() {
     VkExtent2D extent = m_window.getExtent();
 
     vkDeviceWaitIdle(m_device.getDevice());
+    // the old swapchain's render pass is destroyed below: no compile may still be using it
+    m_pipelines.waitForCompiles();
 
     if(m_swapchain == nullptr) {
         m_swapchain = std::make_unique<VulkanSwapchain>(m_device, extent);
@@ -77,9 +275,16 @@ void MApplication::reCreateSwapchain() {
         } 
     }
 
-    createPipeline();
+    m_swapchain->setFrameStats(&m_frameStats);
 
-    std::cout << "width: " << m_window.getExtent().width << "; height: " << m_window.getExtent().height << "\n";
+    // a pipeline works with any compatible render pass: same formats, nothing to rebuild,
+    // later compiles just use the new one
+    m_pipelines.setRenderPass(m_swapchain->getRenderPass());
+    if (m_pipelineFormat != m_swapchain->getSwapChainImageFormat()) {
+        createPipeline();
+    }
+
+    MOO_LOG_DEBUG("width: %u; height: %u", m_window.getExtent().width, m_window.getExtent().height);
 }
 
 void MApplication::createCommandBuffers() {
@@ -90,11 +295,74 @@ void MApplication::createCommandBuffers() {
     if(vkAllocateCommandBuffers(m_device.getDevice(), &commandBufferInfo, m_commandBuffers.data()) != VK_SUCCESS) {
         throw std::runtime_error("Failed to allocate command buffers.");
     }    
+
+    m_descriptors = std::make_unique<VulkanDescriptorAllocator>(m_device.getDevice(), m_device.getLayoutCache(), static_cast<uint32_t>(m_commandBuffers.size()));
+    createTimestampQueryPool();
+    createCullingPass();
 }
 
 void MApplication::freeCommandBuffers() {
     vkFreeCommandBuffers(m_device.getDevice(), m_device.getCommandPool(), static_cast<uint32_t>(m_commandBuffers.size()), m_commandBuffers.data());
     m_commandBuffers.clear();
+
+    destroyTimestampQueryPool();
+    m_cullingPass.reset();
+    m_descriptors.reset();
+}
+
+void MApplication::createTimestampQueryPool() {
+    // timestampComputeAndGraphics guarantees timestamps on every graphics queue
+    if (!m_device.m_deviceProperties.limits.timestampComputeAndGraphics) {
+        return;
+    }
+
+    VkQueryPoolCreateInfo queryPoolInfo {};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = static_cast<uint32_t>(m_commandBuffers.size() * 2);
+
+    if (vkCreateQueryPool(m_device.getDevice(), &queryPoolInfo, nullptr, &m_timestampPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create timestamp query pool.");
+    }
+
+    m_timestampsWritten.assign(m_commandBuffers.size(), false);
+}
+
+void MApplication::destroyTimestampQueryPool() {
+    if (m_timestampPool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(m_device.getDevice(), m_timestampPool, nullptr);
+        m_timestampPool = VK_NULL_HANDLE;
+    }
+    m_timestampsWritten.clear();
+}
+
+void MApplication::createCullingPass() {
+    // empty on the CPU culling path
+    if (m_sceneObjects.empty()) {
+        return;
+    }
+
+    m_cullingPass = std::make_unique<VulkanCullingPass>(m_device, MAX_SCENE_OBJECTS, static_cast<uint32_t>(m_commandBuffers.size()));
+    if (m_cullingPass->setObjects(m_sceneObjects) < m_sceneObjects.size()) {
+        MOO_LOG_WARNING("Scene objects past %u are not drawn.", MAX_SCENE_OBJECTS);
+    }
+}
+
+void MApplication::collectGpuFrameTime(int imgIndex) {
+    if (m_timestampPool == VK_NULL_HANDLE || !m_timestampsWritten[imgIndex]) {
+        return;
+    }
+
+    // no WAIT bit: if the previous submission of this command buffer is still running
+    // the sample is dropped instead of stalling the frame
+    std::array<uint64_t, 2> timestamps {};
+    VkResult result = vkGetQueryPoolResults(m_device.getDevice(), m_timestampPool, static_cast<uint32_t>(imgIndex * 2), 2,
+        sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+    if (result == VK_SUCCESS && timestamps[1] >= timestamps[0]) {
+        double nanoseconds = static_cast<double>(timestamps[1] - timestamps[0]) * m_device.m_deviceProperties.limits.timestampPeriod;
+        m_frameStats.record(MFrameStats::Metric::GpuFrame, static_cast<float>(nanoseconds / 1000000.0));
+    }
 }
 
 void MApplication::recordCommandBuffer(int imgIndex) {
@@ -104,6 +372,19 @@ void MApplication::recordCommandBuffer(int imgIndex) {
         throw std::runtime_error("Failed to begin recording command buffer.");
     }
 
+    // the image's previous command buffer has completed: its sets can go
+    m_descriptors->beginFrame(static_cast<uint32_t>(imgIndex));
+
+    if (m_timestampPool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(m_commandBuffers[imgIndex], m_timestampPool, static_cast<uint32_t>(imgIndex * 2), 2);
+        vkCmdWriteTimestamp(m_commandBuffers[imgIndex], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestampPool, static_cast<uint32_t>(imgIndex * 2));
+    }
+
+    // no camera yet: the view-projection is the identity
+    if (m_cullingPass) {
+        m_cullingPass->cull(m_commandBuffers[imgIndex], static_cast<uint32_t>(imgIndex), glm::mat4{1.0f});
+    }
+
     VkRenderPassBeginInfo renderPassInfo = vkinit::renderpassBeginInfo(m_swapchain->getRenderPass(), m_swapchain->getSwapChainExtent(), m_swapchain->getFrameBuffer(imgIndex));
 /*
     std::array<VkClearValue, 2> clearValues{};
@@ -116,6 +397,13 @@ void MApplication::recordCommandBuffer(int imgIndex) {
     renderPassInfo.pClearValues = &clearValues;
 
     vkCmdBeginRenderPass(m_commandBuffers[imgIndex], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    m_encoder.begin(m_commandBuffers[imgIndex]);
+
+    // every material's resources, bound once: draws only push their indices
+    if (m_bindless) {
+        m_bindless->beginFrame();
+        m_bindless->bind(m_encoder, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout);
+    }
 
 // dynamic viewport scissor
     VkViewport viewport {};
@@ -130,21 +418,70 @@ void MApplication::recordCommandBuffer(int imgIndex) {
     scissor.offset = {0, 0};
     scissor.extent = m_swapchain->getSwapChainExtent();
 
-    vkCmdSetViewport(m_commandBuffers[imgIndex], 0, 1, &viewport);
-    vkCmdSetScissor(m_commandBuffers[imgIndex], 0, 1, &scissor);
+    m_encoder.setViewport(viewport);
+    m_encoder.setScissor(scissor);
 
     // once we start adding rendering commands, 
     // CODE HERE |
     //           V
 
-    m_pipeline->bind(m_commandBuffers[imgIndex]);
-    model1->bind(m_commandBuffers[imgIndex]);
-    model1->draw(m_commandBuffers[imgIndex]);
+    // still compiling: the draw is skipped, the frame isn't held up
+    VkPipeline pipeline = m_pipelines.get(m_pipeline);
+    if (pipeline != VK_NULL_HANDLE) {
+        // every pipeline drawn here declares these states dynamic: set once, kept across binds
+        if (m_extendedDynamicState) {
+            m_encoder.getDynamicState().apply(VulkanDynamicState::State{});
+        }
+        // no camera yet: model space is clip space, only the simulated spin applies
+        VulkanModel::PushConstants constants {};
+        constants.transform = glm::rotate(glm::mat4{1.0f}, m_renderState.angle, glm::vec3{0.0f, 0.0f, 1.0f});
+
+        if (m_cullingPass) {
+            m_encoder.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline, m_pipelineDynamicStates);
+            m_encoder.push<VulkanModel::PushBlock>(m_pipelineLayout, constants);
+            model1->bind(m_encoder);
+            m_cullingPass->draw(m_commandBuffers[imgIndex], static_cast<uint32_t>(imgIndex));
+        } else {
+            // same identity view-projection as the GPU pass; object i of the culler is model1 for now
+            m_culler.cull(VulkanCullingPass::extractFrustumPlanes(glm::mat4{1.0f}), m_visible, &m_pipelineCompiler.getThreadPool());
+            float screenRadius = model1->getBoundingSphere().w * viewport.height * 0.5f;     // clip space is model space
+            // opaque: front to back, depth of the bounding sphere center
+            glm::vec4 center = constants.transform * glm::vec4{glm::vec3{model1->getBoundingSphere()}, 1.0f};
+            uint16_t depth = VulkanRenderQueue::quantizeDepth(center.z / center.w);
+            const uint32_t mesh = 0;    // model1, the only mesh so far
+            for (uint32_t object : m_visible) {
+                m_objectLods[object] = MMeshSimplifier::selectLod(model1->getLods(), screenRadius, LOD_PIXEL_ERROR, m_objectLods[object]);
+
+                VulkanRenderQueue::Draw draw {};
+                draw.pipeline = pipeline;
+                draw.dynamicStates = m_pipelineDynamicStates;
+                draw.layout = m_pipelineLayout;
+                draw.model = model1.get();
+                draw.lod = m_objectLods[object];
+                draw.pushConstants = true;
+                draw.constants = constants;
+                m_renderQueue.push(VulkanRenderQueue::makeKey(0, m_pipeline, 0, mesh, depth), draw);
+            }
+        }
+    }
+
+    m_renderQueue.sort();
+    m_renderQueue.submit(m_encoder);
+    m_renderQueue.clear();
+
+    VulkanCommandEncoder::Stats encoderStats = m_encoder.getStats();
+    MOO_LOG_TRACE("commands: %u recorded, %u redundant skipped", encoderStats.totalIssued(), encoderStats.totalElided());
    
     //           ^
     // STOP HERE |
 
     vkCmdEndRenderPass(m_commandBuffers[imgIndex]);
+
+    if (m_timestampPool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(m_commandBuffers[imgIndex], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestampPool, static_cast<uint32_t>(imgIndex * 2 + 1));
+        m_timestampsWritten[imgIndex] = true;
+    }
+
     if(vkEndCommandBuffer(m_commandBuffers[imgIndex]) != VK_SUCCESS) {
         throw std::runtime_error("Failed to record command buffer.");
     }
@@ -156,19 +493,22 @@ void MApplication::drawFrame() {
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         reCreateSwapchain();
-        std::cout << "VK_ERROR_OUT_OF_DATE_KHR\n";
+        m_window.requestRedraw(); // nothing was presented
+        MOO_LOG_DEBUG("VK_ERROR_OUT_OF_DATE_KHR");
         return;
     } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         throw std::runtime_error("Failed to acquire swapchain image.");
     }
 
+    collectGpuFrameTime(imageIndex);
     recordCommandBuffer(imageIndex);
     result = m_swapchain->submitCommandBuffers(&m_commandBuffers[imageIndex], &imageIndex);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_window.wasWindowResized()) {
         m_window.resetWindowResizedFlag();
         reCreateSwapchain();
-        std::cout << "m_window.wasWindowResized()\n";
+        m_window.requestRedraw(); // present the scene at the new size
+        MOO_LOG_DEBUG("m_window.wasWindowResized()");
         return;
     } else if (result != VK_SUCCESS) {
         throw std::runtime_error("Failed to present swapchain image.");
@@ -189,5 +529,19 @@ void MApplication::loadModels() {
     builder.indices =
     {0, 1, 2, 2, 3, 0};
 
+    builder.generateLods();
     model1 = std::make_unique<VulkanModel>(m_device, builder);
+    m_culler.addSphere(builder.getBoundingSphere());
+    m_objectLods.push_back(UINT32_MAX);
+
+    // otherwise culled on the CPU
+    if (GPU_DRIVEN_DRAWS && VulkanCullingPass::isSupported(m_device, MAX_SCENE_OBJECTS)) {
+        // one object until the vertex shader reads per-instance transforms (firstInstance)
+        VulkanCullingPass::Object object {};
+        object.boundingSphere = builder.getBoundingSphere();
+        object.indexCount = model1->getIndexCount();
+        if (object.indexCount > 0) {
+            m_sceneObjects.push_back(object);
+        }
+    }
 }
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "MFileMapping.h"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+using namespace moo;
+
+#ifdef _WIN32
+
+MFileMapping::MFileMapping(const std::string& filepath) {
+    HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open file: " + filepath);
+    }
+
+    LARGE_INTEGER filesize {};
+    if (!GetFileSizeEx(file, &filesize) || filesize.QuadPart == 0) {
+        CloseHandle(file);
+        throw std::runtime_error("Failed to map empty file: " + filepath);
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        throw std::runtime_error("Failed to map file: " + filepath);
+    }
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("Failed to map file: " + filepath);
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = view;
+    m_size = static_cast<size_t>(filesize.QuadPart);
+}
+
+void MFileMapping::unmap() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle(static_cast<HANDLE>(m_mapping));
+    }
+    if (m_file) {
+        CloseHandle(static_cast<HANDLE>(m_file));
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mapping = nullptr;
+    m_file = nullptr;
+}
+
+#else
+
+MFileMapping::MFileMapping(const std::string& filepath) {
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file: " + filepath);
+    }
+
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Failed to map empty file: " + filepath);
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps its own reference to the file
+
+    if (view == MAP_FAILED) {
+        throw std::runtime_error("Failed to map file: " + filepath);
+    }
+
+    m_data = view;
+    m_size = static_cast<size_t>(info.st_size);
+}
+
+void MFileMapping::unmap() {
+    if (m_data) {
+        munmap(const_cast<void*>(m_data), m_size);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
+
+MFileMapping::~MFileMapping() {
+    unmap();
+}
+
+MFileMapping::MFileMapping(MFileMapping&& other) noexcept {
+    *this = std::move(other);
+}
+
+MFileMapping& MFileMapping::operator=(MFileMapping&& other) noexcept {
+    if (this != &other) {
+        unmap();
+
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+        m_file = std::exchange(other.m_file, nullptr);
+        m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+    }
+    return *this;
+}
@@ -0,0 +1,200 @@
+#include "MFrameStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace moo;
+
+MFrameStats::ScopedTimer::ScopedTimer(MFrameStats* stats, Metric metric) : m_stats{stats}, m_metric{metric} {
+    if (m_stats) {
+        m_start = std::chrono::steady_clock::now();
+    }
+}
+
+MFrameStats::ScopedTimer::~ScopedTimer() {
+    if (m_stats) {
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - m_start;
+        m_stats->add(m_metric, elapsed.count());
+    }
+}
+
+MFrameStats::MFrameStats(uint32_t windowSize) : m_windowSize{std::max(windowSize, 1u)} {
+    for (Window& window : m_windows) {
+        window.samples.resize(m_windowSize, 0.0f);
+        window.buckets.resize(BUCKET_COUNT, 0);
+    }
+
+    m_startTime = std::chrono::steady_clock::now();
+    m_frameStart = m_startTime;
+    m_lastReport = m_startTime;
+}
+
+MFrameStats::~MFrameStats() {
+    if (m_reportFile.is_open()) {
+        m_reportFile.close();
+    }
+}
+
+const char* MFrameStats::metricName(Metric metric) {
+    switch (metric) {
+    case Metric::CpuFrame:  return "cpu_frame";
+    case Metric::GpuFrame:  return "gpu_frame";
+    case Metric::WaitFence: return "wait_fence";
+    case Metric::Acquire:   return "acquire";
+    case Metric::Present:   return "present";
+    default:                return "unknown";
+    }
+}
+
+uint32_t MFrameStats::bucketIndex(float milliseconds) {
+    if (!(milliseconds > 0.0f)) {
+        return 0;
+    }
+
+    float index = milliseconds / BUCKET_WIDTH_MS;
+    if (index >= static_cast<float>(BUCKET_COUNT - 1)) {
+        return BUCKET_COUNT - 1;
+    }
+    return static_cast<uint32_t>(index);
+}
+
+bool MFrameStats::setReportFile(const std::string& filepath) {
+    if (m_reportFile.is_open()) {
+        m_reportFile.close();
+    }
+
+    if (filepath.empty()) {
+        return true;
+    }
+
+    m_reportFile.open(filepath, std::ios::out | std::ios::trunc);
+    if (!m_reportFile.is_open()) {
+        return false;
+    }
+
+    m_reportFile << "time_s,metric,p50_ms,p95_ms,p99_ms,max_ms,samples\n";
+    return true;
+}
+
+void MFrameStats::beginFrame() {
+    m_frameStart = std::chrono::steady_clock::now();
+    m_frameAccum.fill(0.0f);
+    m_frameTouched.fill(false);
+}
+
+bool MFrameStats::endFrame() {
+    auto now = std::chrono::steady_clock::now();
+
+    std::chrono::duration<float, std::milli> cpuFrame = now - m_frameStart;
+    record(Metric::CpuFrame, cpuFrame.count());
+
+    // blocking metrics only get a sample on frames that actually went through them,
+    // an early-out frame (out of date swapchain) must not dilute the window with zeros
+    for (size_t i = 0; i < METRIC_COUNT; i++) {
+        if (m_frameTouched[i]) {
+            record(static_cast<Metric>(i), m_frameAccum[i]);
+        }
+    }
+
+    std::chrono::duration<double> sinceReport = now - m_lastReport;
+    if (sinceReport.count() < m_reportInterval) {
+        return false;
+    }
+
+    m_lastReport = now;
+    report();
+    return true;
+}
+
+void MFrameStats::add(Metric metric, float milliseconds) {
+    size_t index = static_cast<size_t>(metric);
+    m_frameAccum[index] += milliseconds;
+    m_frameTouched[index] = true;
+}
+
+void MFrameStats::record(Metric metric, float milliseconds) {
+    Window& window = m_windows[static_cast<size_t>(metric)];
+
+    if (window.count == m_windowSize) {
+        // evict the oldest sample, it sits where the new one is going
+        window.buckets[bucketIndex(window.samples[window.head])]--;
+    } else {
+        window.count++;
+    }
+
+    window.samples[window.head] = milliseconds;
+    window.buckets[bucketIndex(milliseconds)]++;
+    window.head = (window.head + 1) % m_windowSize;
+}
+
+MFrameStats::Percentiles MFrameStats::percentiles(Metric metric) const {
+    const Window& window = m_windows[static_cast<size_t>(metric)];
+
+    Percentiles result {};
+    result.samples = window.count;
+    if (window.count == 0) {
+        return result;
+    }
+
+    // max is exact, the ring is only scanned on report
+    for (uint32_t i = 0; i < window.count; i++) {
+        result.max = std::max(result.max, window.samples[i]);
+    }
+
+    const uint32_t rank50 = static_cast<uint32_t>(std::ceil(0.50 * window.count));
+    const uint32_t rank95 = static_cast<uint32_t>(std::ceil(0.95 * window.count));
+    const uint32_t rank99 = static_cast<uint32_t>(std::ceil(0.99 * window.count));
+
+    // percentiles resolve to the upper edge of their bucket, clamped to the real max
+    uint32_t cumulative = 0;
+    bool found50 = false, found95 = false;
+    for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+        cumulative += window.buckets[i];
+        float edge = (i == BUCKET_COUNT - 1) ? result.max : std::min(static_cast<float>(i + 1) * BUCKET_WIDTH_MS, result.max);
+
+        if (!found50 && cumulative >= rank50) {
+            result.p50 = edge;
+            found50 = true;
+        }
+        if (!found95 && cumulative >= rank95) {
+            result.p95 = edge;
+            found95 = true;
+        }
+        if (cumulative >= rank99) {
+            result.p99 = edge;
+            break;
+        }
+    }
+
+    return result;
+}
+
+void MFrameStats::report() {
+    std::chrono::duration<double> elapsed = m_lastReport - m_startTime;
+
+    if (m_reportFile.is_open()) {
+        for (size_t i = 0; i < METRIC_COUNT; i++) {
+            Percentiles p = percentiles(static_cast<Metric>(i));
+            if (p.samples == 0) {
+                continue;
+            }
+
+            m_reportFile << elapsed.count() << ',' << metricName(static_cast<Metric>(i)) << ','
+                << p.p50 << ',' << p.p95 << ',' << p.p99 << ',' << p.max << ',' << p.samples << '\n';
+        }
+        m_reportFile.flush();
+    }
+
+    Percentiles cpu = percentiles(Metric::CpuFrame);
+    Percentiles gpu = percentiles(Metric::GpuFrame);
+
+    char buffer[128];
+    if (gpu.samples > 0) {
+        std::snprintf(buffer, sizeof(buffer), "cpu p50 %.2f p99 %.2f max %.2f ms | gpu p50 %.2f p99 %.2f ms",
+            cpu.p50, cpu.p99, cpu.max, gpu.p50, gpu.p99);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "cpu p50 %.2f p99 %.2f max %.2f ms", cpu.p50, cpu.p99, cpu.max);
+    }
+    m_summary = buffer;
+}
\ No newline at end of file
@@ -0,0 +1,330 @@
+#include "MFrustumCuller.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define MOO_CULL_X64 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define MOO_TARGET_AVX2
+#else
+#define MOO_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace moo;
+
+namespace {
+
+struct Streams {
+    const float* centerX;
+    const float* centerY;
+    const float* centerZ;
+    const float* extentX;
+    const float* extentY;
+    const float* extentZ;
+    const float* radius;
+};
+
+// plane test: d = n.c + w, the volume reaches r = radius + |n|.extents toward the plane
+struct Plane {
+    float nx, ny, nz, w;
+    float ax, ay, az;   // |n|
+};
+
+using PlaneSet = std::array<Plane, 6>;
+
+PlaneSet makePlanes(const MFrustumCuller::Planes& planes) {
+    PlaneSet set {};
+    for (size_t i = 0; i < planes.size(); i++) {
+        set[i] = {planes[i].x, planes[i].y, planes[i].z, planes[i].w,
+            std::fabs(planes[i].x), std::fabs(planes[i].y), std::fabs(planes[i].z)};
+    }
+    return set;
+}
+
+// writes every lane and advances past the visible ones only: no branch per object.
+// out[count] stays inside the batch, count never exceeds the lanes tested so far
+inline uint32_t compact(uint32_t mask, uint32_t base, uint32_t lanes, uint32_t* out) {
+    uint32_t count = 0;
+    for (uint32_t lane = 0; lane < lanes; lane++) {
+        out[count] = base + lane;
+        count += (mask >> lane) & 1u;
+    }
+    return count;
+}
+
+uint32_t cullScalar(const Streams& s, const PlaneSet& planes, uint32_t begin, uint32_t end, uint32_t* out) {
+    uint32_t count = 0;
+    for (uint32_t i = begin; i < end; i++) {
+        bool visible = true;
+        for (const Plane& p : planes) {
+            float distance = p.nx * s.centerX[i] + p.ny * s.centerY[i] + p.nz * s.centerZ[i] + p.w;
+            float reach = s.radius[i] + p.ax * s.extentX[i] + p.ay * s.extentY[i] + p.az * s.extentZ[i];
+            visible &= distance + reach >= 0.0f;
+        }
+        out[count] = i;
+        count += visible ? 1u : 0u;
+    }
+    return count;
+}
+
+#ifdef MOO_CULL_X64
+
+// SSE2, part of x64: nothing to detect
+uint32_t cullSse(const Streams& s, const PlaneSet& planes, uint32_t begin, uint32_t end, uint32_t* out) {
+    uint32_t count = 0;
+    uint32_t i = begin;
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= end; i += 4) {
+        __m128 cx = _mm_loadu_ps(s.centerX + i);
+        __m128 cy = _mm_loadu_ps(s.centerY + i);
+        __m128 cz = _mm_loadu_ps(s.centerZ + i);
+        __m128 ex = _mm_loadu_ps(s.extentX + i);
+        __m128 ey = _mm_loadu_ps(s.extentY + i);
+        __m128 ez = _mm_loadu_ps(s.extentZ + i);
+        __m128 r = _mm_loadu_ps(s.radius + i);
+
+        __m128 visible = _mm_cmpeq_ps(zero, zero);
+        for (const Plane& p : planes) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.nx), cx), _mm_mul_ps(_mm_set1_ps(p.ny), cy)),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.nz), cz), _mm_set1_ps(p.w)));
+            __m128 reach = _mm_add_ps(_mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(p.ax), ex)),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.ay), ey), _mm_mul_ps(_mm_set1_ps(p.az), ez)));
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(_mm_add_ps(distance, reach), zero));
+        }
+        count += compact(static_cast<uint32_t>(_mm_movemask_ps(visible)), i, 4, out + count);
+    }
+    return count + cullScalar(s, planes, i, end, out + count);
+}
+
+MOO_TARGET_AVX2
+uint32_t cullAvx2(const Streams& s, const PlaneSet& planes, uint32_t begin, uint32_t end, uint32_t* out) {
+    uint32_t count = 0;
+    uint32_t i = begin;
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= end; i += 8) {
+        __m256 cx = _mm256_loadu_ps(s.centerX + i);
+        __m256 cy = _mm256_loadu_ps(s.centerY + i);
+        __m256 cz = _mm256_loadu_ps(s.centerZ + i);
+        __m256 ex = _mm256_loadu_ps(s.extentX + i);
+        __m256 ey = _mm256_loadu_ps(s.extentY + i);
+        __m256 ez = _mm256_loadu_ps(s.extentZ + i);
+        __m256 r = _mm256_loadu_ps(s.radius + i);
+
+        __m256 visible = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+        for (const Plane& p : planes) {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.nx), cx), _mm256_mul_ps(_mm256_set1_ps(p.ny), cy)),
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.nz), cz), _mm256_set1_ps(p.w)));
+            __m256 reach = _mm256_add_ps(_mm256_add_ps(r, _mm256_mul_ps(_mm256_set1_ps(p.ax), ex)),
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.ay), ey), _mm256_mul_ps(_mm256_set1_ps(p.az), ez)));
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(_mm256_add_ps(distance, reach), zero, _CMP_GE_OQ));
+        }
+        count += compact(static_cast<uint32_t>(_mm256_movemask_ps(visible)), i, 8, out + count);
+    }
+    return count + cullSse(s, planes, i, end, out + count);
+}
+
+bool cpuHasAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    // AVX enabled by the OS (ymm state saved on context switch), then AVX2
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+uint32_t cullBatch(MFrustumCuller::Isa isa, const Streams& s, const PlaneSet& planes, uint32_t begin, uint32_t end, uint32_t* out) {
+#ifdef MOO_CULL_X64
+    if (isa == MFrustumCuller::Isa::Avx2) {
+        return cullAvx2(s, planes, begin, end, out);
+    }
+    if (isa == MFrustumCuller::Isa::Sse) {
+        return cullSse(s, planes, begin, end, out);
+    }
+#endif
+    (void)isa;
+    return cullScalar(s, planes, begin, end, out);
+}
+
+// batches of one cull() call, shared with the pool jobs: a job that starts late finds
+// nothing left to claim and touches nothing else
+struct CullJob {
+    Streams streams;
+    PlaneSet planes;
+    MFrustumCuller::Isa isa;
+    uint32_t objectCount;
+    uint32_t batchCount;
+    uint32_t* out;
+    std::vector<uint32_t> counts;
+    std::atomic<uint32_t> next {0};
+    std::atomic<uint32_t> done {0};
+
+    void run() {
+        while (true) {
+            uint32_t batch = next.fetch_add(1, std::memory_order_relaxed);
+            if (batch >= batchCount) {
+                return;
+            }
+            uint32_t begin = batch * MFrustumCuller::BATCH_SIZE;
+            uint32_t end = std::min(begin + MFrustumCuller::BATCH_SIZE, objectCount);
+            counts[batch] = cullBatch(isa, streams, planes, begin, end, out + begin);
+            done.fetch_add(1, std::memory_order_release);
+        }
+    }
+};
+
+}   // namespace
+
+MFrustumCuller::MFrustumCuller() : m_isa{detectIsa()} {}
+
+uint32_t MFrustumCuller::addSphere(const glm::vec4& sphere) {
+    m_centerX.push_back(0.0f);
+    m_centerY.push_back(0.0f);
+    m_centerZ.push_back(0.0f);
+    m_extentX.push_back(0.0f);
+    m_extentY.push_back(0.0f);
+    m_extentZ.push_back(0.0f);
+    m_radius.push_back(0.0f);
+
+    uint32_t index = size() - 1;
+    setSphere(index, sphere);
+    return index;
+}
+
+uint32_t MFrustumCuller::addBox(const glm::vec3& min, const glm::vec3& max) {
+    uint32_t index = addSphere(glm::vec4{0.0f});
+    setBox(index, min, max);
+    return index;
+}
+
+void MFrustumCuller::setSphere(uint32_t index, const glm::vec4& sphere) {
+    assert(index < size() && "Culling volume out of range.");
+    m_centerX[index] = sphere.x;
+    m_centerY[index] = sphere.y;
+    m_centerZ[index] = sphere.z;
+    m_extentX[index] = 0.0f;
+    m_extentY[index] = 0.0f;
+    m_extentZ[index] = 0.0f;
+    m_radius[index] = sphere.w;
+}
+
+void MFrustumCuller::setBox(uint32_t index, const glm::vec3& min, const glm::vec3& max) {
+    assert(index < size() && "Culling volume out of range.");
+    m_centerX[index] = (min.x + max.x) * 0.5f;
+    m_centerY[index] = (min.y + max.y) * 0.5f;
+    m_centerZ[index] = (min.z + max.z) * 0.5f;
+    m_extentX[index] = (max.x - min.x) * 0.5f;
+    m_extentY[index] = (max.y - min.y) * 0.5f;
+    m_extentZ[index] = (max.z - min.z) * 0.5f;
+    m_radius[index] = 0.0f;
+}
+
+void MFrustumCuller::clear() {
+    m_centerX.clear();
+    m_centerY.clear();
+    m_centerZ.clear();
+    m_extentX.clear();
+    m_extentY.clear();
+    m_extentZ.clear();
+    m_radius.clear();
+}
+
+void MFrustumCuller::reserve(size_t count) {
+    m_centerX.reserve(count);
+    m_centerY.reserve(count);
+    m_centerZ.reserve(count);
+    m_extentX.reserve(count);
+    m_extentY.reserve(count);
+    m_extentZ.reserve(count);
+    m_radius.reserve(count);
+}
+
+void MFrustumCuller::setIsa(Isa isa) {
+    m_isa = std::min(isa, detectIsa());
+}
+
+MFrustumCuller::Isa MFrustumCuller::detectIsa() {
+#ifdef MOO_CULL_X64
+    static const Isa detected = cpuHasAvx2() ? Isa::Avx2 : Isa::Sse;
+    return detected;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+uint32_t MFrustumCuller::cull(const Planes& planes, std::vector<uint32_t>& visible, MThreadPool* pool) {
+    visible.clear();
+    uint32_t objectCount = size();
+    if (objectCount == 0) {
+        return 0;
+    }
+
+    Streams streams {m_centerX.data(), m_centerY.data(), m_centerZ.data(),
+        m_extentX.data(), m_extentY.data(), m_extentZ.data(), m_radius.data()};
+    uint32_t batchCount = (objectCount + BATCH_SIZE - 1) / BATCH_SIZE;
+
+    // one batch: straight into the result
+    if (batchCount == 1 || pool == nullptr || pool->threadCount() == 0) {
+        visible.resize(objectCount);
+        uint32_t count = cullBatch(m_isa, streams, makePlanes(planes), 0, objectCount, visible.data());
+        visible.resize(count);
+        return count;
+    }
+
+    m_scratch.resize(objectCount);
+    auto job = std::make_shared<CullJob>();
+    job->streams = streams;
+    job->planes = makePlanes(planes);
+    job->isa = m_isa;
+    job->objectCount = objectCount;
+    job->batchCount = batchCount;
+    job->out = m_scratch.data();
+    job->counts.resize(batchCount);
+
+    // the futures are dropped: a helper still queued behind other jobs is not waited for
+    uint32_t helpers = std::min(pool->threadCount(), batchCount - 1);
+    for (uint32_t i = 0; i < helpers; i++) {
+        pool->submit([job]() { job->run(); });
+    }
+    job->run();
+
+    // nothing left to claim: only the batches helpers are still culling
+    while (job->done.load(std::memory_order_acquire) < batchCount) {
+        std::this_thread::yield();
+    }
+
+    // batches were written BATCH_SIZE apart: pack them
+    uint32_t count = 0;
+    for (uint32_t batch = 0; batch < batchCount; batch++) {
+        count += job->counts[batch];
+    }
+    visible.resize(count);
+    uint32_t* packed = visible.data();
+    for (uint32_t batch = 0; batch < batchCount; batch++) {
+        std::memcpy(packed, m_scratch.data() + static_cast<size_t>(batch) * BATCH_SIZE, job->counts[batch] * sizeof(uint32_t));
+        packed += job->counts[batch];
+    }
+    return count;
+}
@@ -0,0 +1,185 @@
+#include "MLogger.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+
+using namespace moo;
+
+namespace {
+
+int64_t nowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}   // namespace
+
+MLogger& MLogger::instance() {
+    static MLogger logger;
+    return logger;
+}
+
+MLogger::MLogger() : m_slots{new Slot[QUEUE_CAPACITY]}, m_startTime{nowNanoseconds()} {
+    static_assert((QUEUE_CAPACITY & (QUEUE_CAPACITY - 1)) == 0, "Logger queue capacity must be a power of two.");
+
+    // slot i is free for the producer that claims position i
+    for (uint32_t i = 0; i < QUEUE_CAPACITY; i++) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    m_writer = std::thread(&MLogger::writerLoop, this);
+}
+
+MLogger::~MLogger() {
+    m_running.store(false, std::memory_order_release);
+    m_wake.notify_one();
+
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+}
+
+const char* MLogger::levelName(LogLevel level) {
+    switch (level) {
+    case LogLevel::Trace:   return "TRACE";
+    case LogLevel::Debug:   return "DEBUG";
+    case LogLevel::Info:    return "INFO ";
+    case LogLevel::Warning: return "WARN ";
+    case LogLevel::Error:   return "ERROR";
+    default:                return "     ";
+    }
+}
+
+void MLogger::log(LogLevel level, const char* format, ...) {
+    // claim a slot: bounded MPSC ring with per-slot sequence numbers
+    uint64_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+
+    for (;;) {
+        slot = &m_slots[pos & (QUEUE_CAPACITY - 1)];
+        uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+
+        if (diff == 0) {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // ring is full: the writer is behind, drop rather than stall the caller
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->timestamp = static_cast<uint64_t>(nowNanoseconds() - m_startTime);
+    slot->level = level;
+
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(slot->text, MESSAGE_SIZE, format, args);
+    va_end(args);
+
+    slot->sequence.store(pos + 1, std::memory_order_seq_cst);
+
+    // only touch the condition variable when the writer actually went to sleep
+    if (m_consumerSleeping.load(std::memory_order_seq_cst)) {
+        m_wake.notify_one();
+    }
+}
+
+void MLogger::flush() {
+    uint64_t target = m_enqueuePos.load(std::memory_order_acquire);
+
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    while (m_dequeuePos.load(std::memory_order_acquire) < target && m_running.load(std::memory_order_acquire)) {
+        m_wake.notify_one();
+        m_drained.wait_for(lock, std::chrono::milliseconds(10));
+    }
+}
+
+void MLogger::setPeriodicTask(std::function<void()> task, std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(m_taskMutex);
+    m_task = std::move(task);
+    m_taskInterval = interval;
+    m_nextTask = std::chrono::steady_clock::now() + interval;
+}
+
+void MLogger::runPeriodicTask() {
+    std::lock_guard<std::mutex> lock(m_taskMutex);
+    if (!m_task) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now < m_nextTask) {
+        return;
+    }
+
+    m_nextTask = now + m_taskInterval;
+    m_task();
+}
+
+uint32_t MLogger::drain() {
+    uint32_t written = 0;
+    uint64_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+
+    for (;;) {
+        Slot& slot = m_slots[pos & (QUEUE_CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_seq_cst) != pos + 1) {
+            break; // not published yet
+        }
+
+        FILE* out = slot.level >= LogLevel::Warning ? stderr : stdout;
+        std::fprintf(out, "[%10.4f] %s %s\n", static_cast<double>(slot.timestamp) / 1e9, levelName(slot.level), slot.text);
+
+        // hand the slot back to the producers one lap later
+        slot.sequence.store(pos + QUEUE_CAPACITY, std::memory_order_release);
+        pos++;
+        written++;
+    }
+
+    if (written > 0) {
+        m_dequeuePos.store(pos, std::memory_order_release);
+        std::fflush(stdout);
+        std::fflush(stderr);
+    }
+
+    return written;
+}
+
+void MLogger::writerLoop() {
+    uint64_t reportedDrops = 0;
+
+    while (m_running.load(std::memory_order_acquire)) {
+        // the wait below times out every 50ms, so the task runs within that of its deadline
+        runPeriodicTask();
+
+        if (drain() > 0) {
+            m_drained.notify_all();
+            continue;
+        }
+
+        uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+        if (dropped != reportedDrops) {
+            std::fprintf(stderr, "[logger] %llu messages dropped, queue full\n", static_cast<unsigned long long>(dropped - reportedDrops));
+            reportedDrops = dropped;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_consumerSleeping.store(true, std::memory_order_seq_cst);
+
+        // recheck after announcing the sleep: a producer may have published in between.
+        // The timeout bounds the latency of the rare wakeup lost between check and wait.
+        const Slot& next = m_slots[m_dequeuePos.load(std::memory_order_relaxed) & (QUEUE_CAPACITY - 1)];
+        if (next.sequence.load(std::memory_order_seq_cst) != m_dequeuePos.load(std::memory_order_relaxed) + 1) {
+            m_wake.wait_for(lock, std::chrono::milliseconds(50));
+        }
+
+        m_consumerSleeping.store(false, std::memory_order_relaxed);
+    }
+
+    drain();
+    m_drained.notify_all();
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "MLoopScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace moo;
+
+MLoopScheduler::MLoopScheduler(double updateRate, double renderCap) : m_updateRate{0.0}, m_renderCap{0.0}, m_step{0.0} {
+    setUpdateRate(updateRate);
+    setRenderCap(renderCap);
+    reset();
+}
+
+void MLoopScheduler::setUpdateRate(double hz) {
+    if (!(hz > 0.0)) {
+        throw std::runtime_error("Failed to set update rate: must be greater than zero.");
+    }
+
+    m_updateRate = hz;
+    m_step = Seconds(1.0 / hz);
+}
+
+void MLoopScheduler::setRenderCap(double fps) {
+    m_renderCap = std::max(fps, 0.0);
+    m_renderInterval = Seconds(m_renderCap > 0.0 ? 1.0 / m_renderCap : 0.0);
+}
+
+void MLoopScheduler::setMaxUpdatesPerFrame(uint32_t updates) {
+    m_maxUpdates = std::max(updates, 1u);
+}
+
+void MLoopScheduler::reset() {
+    m_lastAdvance = Clock::now();
+    m_lastRender = m_lastAdvance - std::chrono::duration_cast<Clock::duration>(m_renderInterval);
+    m_accumulator = Seconds(0.0);
+}
+
+MLoopScheduler::Tick MLoopScheduler::advance(bool frameWanted) {
+    Clock::time_point now = Clock::now();
+    m_accumulator += now - m_lastAdvance;
+    m_lastAdvance = now;
+
+    Tick tick {};
+    while (m_accumulator >= m_step && tick.updates < m_maxUpdates) {
+        m_accumulator -= m_step;
+        tick.updates++;
+    }
+
+    // still behind after the catch-up limit: the simulation slows down instead of
+    // the frame taking longer and longer to catch up
+    if (m_accumulator >= m_step) {
+        Seconds behind = m_accumulator - Seconds(std::fmod(m_accumulator.count(), m_step.count()));
+        m_dropped += behind;
+        m_accumulator -= behind;
+    }
+
+    tick.alpha = static_cast<float>(m_accumulator / m_step);
+
+    if (frameWanted && now - m_lastRender >= m_renderInterval) {
+        tick.render = true;
+        // keep the cadence instead of drifting by the loop overhead, unless we fell a whole interval behind
+        m_lastRender += std::chrono::duration_cast<Clock::duration>(m_renderInterval);
+        if (now - m_lastRender >= m_renderInterval) {
+            m_lastRender = now;
+        }
+    }
+
+    return tick;
+}
+
+MLoopScheduler::Clock::duration MLoopScheduler::timeUntilNextUpdate() const {
+    Seconds wait = m_step - m_accumulator - (Clock::now() - m_lastAdvance);
+    return std::chrono::duration_cast<Clock::duration>(std::max(wait, Seconds(0.0)));
+}
+
+MLoopScheduler::Clock::duration MLoopScheduler::timeUntilNextFrame() const {
+    Seconds wait = m_renderInterval - (Clock::now() - m_lastRender);
+    return std::chrono::duration_cast<Clock::duration>(std::max(wait, Seconds(0.0)));
+}
@@ -0,0 +1,447 @@
+#include "MMeshSimplifier.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace moo;
+
+namespace {
+
+struct Vec3 {
+    float x, y, z;
+};
+
+inline Vec3 sub(const Vec3& a, const Vec3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+inline Vec3 cross(const Vec3& a, const Vec3& b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+inline float dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline float length(const Vec3& a) { return std::sqrt(dot(a, a)); }
+
+// symmetric 4x4 plane quadric, weight: total area, the error is an average squared distance
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+    double weight = 0;
+
+    // plane n.p + d = 0, n unit length
+    void addPlane(const Vec3& n, float d, double w) {
+        a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z; a03 += w * n.x * d;
+        a11 += w * n.y * n.y; a12 += w * n.y * n.z; a13 += w * n.y * d;
+        a22 += w * n.z * n.z; a23 += w * n.z * d;
+        a33 += w * d * d;
+        weight += w;
+    }
+
+    void add(const Quadric& q) {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+        a11 += q.a11; a12 += q.a12; a13 += q.a13;
+        a22 += q.a22; a23 += q.a23;
+        a33 += q.a33;
+        weight += q.weight;
+    }
+
+    double error(const Vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double e = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+                 + a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+                 + a22 * z * z + 2 * a23 * z
+                 + a33;
+        return weight > 0 ? std::fabs(e) / weight : 0.0;
+    }
+};
+
+// border edges weigh this much more than faces: silhouettes of open meshes stay put
+constexpr double BORDER_WEIGHT = 10.0;
+// a collapse turning a triangle's normal further than this (cosine) is a fold, rejected
+constexpr float MIN_NORMAL_DOT = 0.25f;
+
+inline uint64_t edgeKey(uint32_t a, uint32_t b) {
+    return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+}
+
+struct Collapse {
+    float cost;
+    uint32_t from;
+    uint32_t to;
+};
+
+}   // namespace
+
+std::vector<uint32_t> MMeshSimplifier::simplify(const float* positions, const float* attributes, size_t attributeCount,
+    size_t vertexCount, size_t stride, const std::vector<uint32_t>& indices, size_t targetIndexCount,
+    float maxError, float* error)
+{
+    assert(indices.size() % 3 == 0 && "Simplification takes a triangle list.");
+    if (error != nullptr) {
+        *error = 0.0f;
+    }
+    if (indices.size() <= targetIndexCount || vertexCount == 0) {
+        return indices;
+    }
+
+    // positions normalized to the unit sphere of the bounds: errors come out in radii
+    std::vector<Vec3> points(vertexCount);
+    Vec3 minimum {FLT_MAX, FLT_MAX, FLT_MAX};
+    Vec3 maximum {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (size_t i = 0; i < vertexCount; i++) {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + i * stride);
+        points[i] = {p[0], p[1], p[2]};
+        minimum = {std::min(minimum.x, p[0]), std::min(minimum.y, p[1]), std::min(minimum.z, p[2])};
+        maximum = {std::max(maximum.x, p[0]), std::max(maximum.y, p[1]), std::max(maximum.z, p[2])};
+    }
+    // the radius of VulkanModel::Builder::getBoundingSphere, the one LODs are selected with
+    Vec3 center {(minimum.x + maximum.x) * 0.5f, (minimum.y + maximum.y) * 0.5f, (minimum.z + maximum.z) * 0.5f};
+    float radius = 0.0f;
+    for (const Vec3& p : points) {
+        radius = std::max(radius, length(sub(p, center)));
+    }
+    float scale = radius > 0.0f ? 1.0f / radius : 1.0f;
+
+    // vertices at the same position (attribute seams) are one for the topology and the quadrics:
+    // the first of them stands for all
+    std::vector<uint32_t> remap(vertexCount);
+    {
+        struct PositionHash {
+            size_t operator()(const Vec3& p) const {
+                uint32_t bits[3];
+                std::memcpy(bits, &p, sizeof(bits));
+                return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+            }
+        };
+        struct PositionEqual {
+            bool operator()(const Vec3& a, const Vec3& b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+        };
+        std::unordered_map<Vec3, uint32_t, PositionHash, PositionEqual> unique;
+        unique.reserve(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++) {
+            remap[i] = unique.emplace(points[i], static_cast<uint32_t>(i)).first->second;
+        }
+    }
+    for (Vec3& p : points) {
+        p = {(p.x - center.x) * scale, (p.y - center.y) * scale, (p.z - center.z) * scale};
+    }
+
+    // the vertices each one stands for, its copies
+    std::vector<uint32_t> copiesOffset(vertexCount + 1, 0);
+    std::vector<uint32_t> copies(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++) {
+        copiesOffset[remap[i] + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        copiesOffset[v + 1] += copiesOffset[v];
+    }
+    {
+        std::vector<uint32_t> fill(copiesOffset.begin(), copiesOffset.end() - 1);
+        for (size_t i = 0; i < vertexCount; i++) {
+            copies[fill[remap[i]]++] = static_cast<uint32_t>(i);
+        }
+    }
+    auto onSeam = [&copiesOffset](uint32_t v) { return copiesOffset[v + 1] - copiesOffset[v] > 1; };
+
+    // a corner moved to vertex to: the copy of to whose attributes are the nearest to its own
+    auto attributeAt = [attributes, stride](uint32_t v) {
+        return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(attributes) + v * stride);
+    };
+    auto moveCorner = [&](uint32_t corner, uint32_t to) {
+        uint32_t best = to;
+        if (attributes == nullptr || !onSeam(to)) {
+            return best;
+        }
+        const float* own = attributeAt(corner);
+        float bestDistance = FLT_MAX;
+        for (uint32_t c = copiesOffset[to]; c < copiesOffset[to + 1]; c++) {
+            const float* other = attributeAt(copies[c]);
+            float distance = 0.0f;
+            for (size_t k = 0; k < attributeCount; k++) {
+                distance += (other[k] - own[k]) * (other[k] - own[k]);
+            }
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = copies[c];
+            }
+        }
+        return best;
+    };
+
+    // triangles: the welded vertices, collapsed and tested; corners: the vertices written out
+    std::vector<uint32_t> triangles;
+    std::vector<uint32_t> corners;
+    triangles.reserve(indices.size());
+    corners.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        uint32_t a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+        if (a != b && b != c && c != a) {
+            triangles.insert(triangles.end(), {a, b, c});
+            corners.insert(corners.end(), {indices[i], indices[i + 1], indices[i + 2]});
+        }
+    }
+
+    // border: edges of a single triangle
+    std::unordered_map<uint64_t, uint32_t> edgeUse;
+    for (size_t i = 0; i < triangles.size(); i += 3) {
+        for (int e = 0; e < 3; e++) {
+            edgeUse[edgeKey(triangles[i + e], triangles[i + (e + 1) % 3])]++;
+        }
+    }
+    std::unordered_set<uint64_t> borderEdges;
+    std::vector<bool> onBorder(vertexCount, false);
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < triangles.size(); i += 3) {
+        const Vec3& p0 = points[triangles[i]];
+        const Vec3& p1 = points[triangles[i + 1]];
+        const Vec3& p2 = points[triangles[i + 2]];
+        Vec3 normal = cross(sub(p1, p0), sub(p2, p0));
+        float area = length(normal);
+        if (area == 0.0f) {
+            continue;
+        }
+        normal = {normal.x / area, normal.y / area, normal.z / area};
+        float d = -dot(normal, p0);
+        for (int v = 0; v < 3; v++) {
+            quadrics[triangles[i + v]].addPlane(normal, d, area);
+        }
+
+        // border edge: a plane through it, perpendicular to the face
+        for (int e = 0; e < 3; e++) {
+            uint32_t a = triangles[i + e], b = triangles[i + (e + 1) % 3];
+            uint64_t key = edgeKey(a, b);
+            if (edgeUse[key] != 1) {
+                continue;
+            }
+            borderEdges.insert(key);
+            onBorder[a] = onBorder[b] = true;
+
+            Vec3 edge = sub(points[b], points[a]);
+            float edgeLength = length(edge);
+            Vec3 side = cross(edge, normal);
+            float sideLength = length(side);
+            if (sideLength == 0.0f) {
+                continue;
+            }
+            side = {side.x / sideLength, side.y / sideLength, side.z / sideLength};
+            double w = BORDER_WEIGHT * edgeLength * edgeLength;
+            quadrics[a].addPlane(side, -dot(side, points[a]), w);
+            quadrics[b].addPlane(side, -dot(side, points[a]), w);
+        }
+    }
+
+    edgeUse.clear();
+
+    double maxCost = static_cast<double>(maxError) * maxError;
+    double reached = 0.0;
+
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> collapseTo(vertexCount);
+    std::vector<bool> locked(vertexCount);
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+
+    // passes of independent collapses, cheapest first, until the target or the error bound
+    while (triangles.size() > targetIndexCount) {
+        // triangles around each vertex
+        std::fill(adjacencyOffset.begin(), adjacencyOffset.end(), 0);
+        for (uint32_t v : triangles) {
+            adjacencyOffset[v + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; v++) {
+            adjacencyOffset[v + 1] += adjacencyOffset[v];
+        }
+        adjacency.resize(triangles.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+            for (size_t i = 0; i < triangles.size(); i++) {
+                adjacency[fill[triangles[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        // every edge once, in the direction that costs less
+        collapses.clear();
+        for (size_t i = 0; i < triangles.size(); i += 3) {
+            for (int e = 0; e < 3; e++) {
+                uint32_t a = triangles[i + e], b = triangles[i + (e + 1) % 3];
+                bool border = borderEdges.count(edgeKey(a, b)) > 0;
+                if (!border && a > b) {
+                    continue;   // interior edges are seen from both sides, keep one
+                }
+                // a border vertex only slides along the border, a seam vertex along the seam
+                bool aMoves = (!onBorder[a] || border) && (!onSeam(a) || onSeam(b));
+                bool bMoves = (!onBorder[b] || border) && (!onSeam(b) || onSeam(a));
+
+                Quadric q = quadrics[a];
+                q.add(quadrics[b]);
+                double toB = aMoves ? q.error(points[b]) : DBL_MAX;
+                double toA = bMoves ? q.error(points[a]) : DBL_MAX;
+                if (toB == DBL_MAX && toA == DBL_MAX) {
+                    continue;
+                }
+                if (toB <= toA) {
+                    collapses.push_back({static_cast<float>(toB), a, b});
+                } else {
+                    collapses.push_back({static_cast<float>(toA), b, a});
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        for (size_t v = 0; v < vertexCount; v++) {
+            collapseTo[v] = static_cast<uint32_t>(v);
+        }
+        std::fill(locked.begin(), locked.end(), false);
+
+        size_t triangleCount = triangles.size() / 3;
+        size_t targetTriangles = targetIndexCount / 3;
+        size_t removed = 0;
+        for (const Collapse& collapse : collapses) {
+            if (collapse.cost > maxCost || triangleCount - removed <= targetTriangles) {
+                break;
+            }
+            if (locked[collapse.from] || locked[collapse.to]) {
+                continue;
+            }
+
+            // the from vertex's triangles that survive must keep facing the same way
+            bool flips = false;
+            size_t lost = 0;
+            for (uint32_t t = adjacencyOffset[collapse.from]; t < adjacencyOffset[collapse.from + 1] && !flips; t++) {
+                const uint32_t* tri = &triangles[adjacency[t] * 3];
+                if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to) {
+                    lost++;
+                    continue;
+                }
+                Vec3 before[3] = {points[tri[0]], points[tri[1]], points[tri[2]]};
+                Vec3 after[3] = {before[0], before[1], before[2]};
+                for (int v = 0; v < 3; v++) {
+                    if (tri[v] == collapse.from) {
+                        after[v] = points[collapse.to];
+                    }
+                }
+                Vec3 n0 = cross(sub(before[1], before[0]), sub(before[2], before[0]));
+                Vec3 n1 = cross(sub(after[1], after[0]), sub(after[2], after[0]));
+                float l0 = length(n0), l1 = length(n1);
+                flips = l1 == 0.0f || (l0 > 0.0f && dot(n0, n1) < MIN_NORMAL_DOT * l0 * l1);
+            }
+            if (flips) {
+                continue;
+            }
+
+            collapseTo[collapse.from] = collapse.to;
+            locked[collapse.from] = locked[collapse.to] = true;
+            // neighbours too: their triangles were checked against the current positions
+            for (uint32_t t = adjacencyOffset[collapse.from]; t < adjacencyOffset[collapse.from + 1]; t++) {
+                const uint32_t* tri = &triangles[adjacency[t] * 3];
+                locked[tri[0]] = locked[tri[1]] = locked[tri[2]] = true;
+            }
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            reached = std::max(reached, static_cast<double>(collapse.cost));
+            removed += lost;
+        }
+        if (removed == 0) {
+            break;
+        }
+
+        // apply, dropping the triangles that lost an edge
+        size_t write = 0;
+        for (size_t i = 0; i < triangles.size(); i += 3) {
+            uint32_t a = collapseTo[triangles[i]], b = collapseTo[triangles[i + 1]], c = collapseTo[triangles[i + 2]];
+            if (a == b || b == c || c == a) {
+                continue;
+            }
+            for (int v = 0; v < 3; v++) {
+                uint32_t to = collapseTo[triangles[i + v]];
+                corners[write] = to == triangles[i + v] ? corners[i + v] : moveCorner(corners[i + v], to);
+                triangles[write++] = to;
+            }
+        }
+        triangles.resize(write);
+        corners.resize(write);
+
+        // borders follow the collapsed vertices
+        std::unordered_set<uint64_t> remapped;
+        for (uint64_t key : borderEdges) {
+            uint32_t a = collapseTo[static_cast<uint32_t>(key >> 32)], b = collapseTo[static_cast<uint32_t>(key)];
+            if (a != b) {
+                remapped.insert(edgeKey(a, b));
+            }
+        }
+        borderEdges.swap(remapped);
+    }
+
+    if (error != nullptr) {
+        *error = static_cast<float>(std::sqrt(reached));
+    }
+    return corners;
+}
+
+std::vector<MMeshSimplifier::Lod> MMeshSimplifier::buildLodChain(const float* positions, const float* attributes, size_t attributeCount,
+    size_t vertexCount, size_t stride, std::vector<uint32_t>& indices, uint32_t maxLods, float reduction)
+{
+    std::vector<Lod> lods;
+    Lod base {};
+    base.indexCount = static_cast<uint32_t>(indices.size());
+    lods.push_back(base);
+
+    // each LOD from the previous one: cheaper, the errors add up
+    std::vector<uint32_t> source = indices;
+    while (lods.size() < maxLods) {
+        size_t target = static_cast<size_t>(static_cast<float>(source.size() / 3) * reduction) * 3;
+        if (target < 3) {
+            break;
+        }
+
+        float error = 0.0f;
+        std::vector<uint32_t> simplified = simplify(positions, attributes, attributeCount, vertexCount, stride, source, target, MAX_ERROR - lods.back().error, &error);
+        // under a tenth fewer triangles: not worth a LOD
+        if (simplified.empty() || simplified.size() * 10 > source.size() * 9) {
+            break;
+        }
+
+        Lod lod {};
+        lod.firstIndex = static_cast<uint32_t>(indices.size());
+        lod.indexCount = static_cast<uint32_t>(simplified.size());
+        lod.error = lods.back().error + error;
+        lods.push_back(lod);
+
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        source.swap(simplified);
+    }
+    return lods;
+}
+
+uint32_t MMeshSimplifier::selectLod(const std::vector<Lod>& lods, float screenRadius, float maxPixelError, uint32_t current) {
+    // errors grow with the LOD: the last one under the threshold
+    auto coarsest = [&lods, screenRadius](float threshold) {
+        uint32_t lod = 0;
+        for (uint32_t i = 1; i < lods.size() && lods[i].error * screenRadius <= threshold; i++) {
+            lod = i;
+        }
+        return lod;
+    };
+
+    if (current >= lods.size()) {
+        return coarsest(maxPixelError);
+    }
+    // coarser only well under the threshold, finer only well over: no flicker at the boundary
+    uint32_t coarser = coarsest(maxPixelError * (1.0f - HYSTERESIS));
+    if (coarser > current) {
+        return coarser;
+    }
+    if (lods[current].error * screenRadius <= maxPixelError * (1.0f + HYSTERESIS)) {
+        return current;
+    }
+    return coarsest(maxPixelError);
+}
+
+float MMeshSimplifier::projectedRadius(float radius, float distance, float fovY, float viewportHeight) {
+    // inside the sphere: as large as it gets
+    if (distance <= radius) {
+        return FLT_MAX;
+    }
+    return radius / (distance * std::tan(fovY * 0.5f)) * viewportHeight * 0.5f;
+}
@@ -0,0 +1,49 @@
+#include "MThreadPool.h"
+
+#include <algorithm>
+
+using namespace moo;
+
+MThreadPool::MThreadPool(uint32_t threadCount) {
+    if (threadCount == 0) {
+        uint32_t cores = std::thread::hardware_concurrency();
+        threadCount = std::max(cores, 2u) - 1;
+    }
+
+    m_workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++) {
+        m_workers.emplace_back(&MThreadPool::workerLoop, this);
+    }
+}
+
+MThreadPool::~MThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void MThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+
+            if (m_jobs.empty()) {
+                return; // stopping and nothing left
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        // packaged_task stores exceptions in the future, nothing escapes here
+        job();
+    }
+}
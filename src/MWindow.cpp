@@ -1,19 +1,24 @@
 #include "MWindow.h"
 
 #include <SDL_vulkan.h>
+#include "MLogger.h"
 
-#include <iostream>
+#include <stdexcept>
 
 using namespace moo;
 
 MWindow::MWindow(std::string title, int w, int h) : 
-    m_window{nullptr}, m_windowTitle{title}, m_width{w}, m_height{h}, 
-    m_quit{false}, m_framebufferResized{false}, m_minimized{false}, m_fullscreen{false}
+    m_window{nullptr}, m_windowTitle{title}, m_extent{packExtent(w, h)}, 
+    m_quit{false}, m_framebufferResized{false}, m_minimized{false},
+    m_redrawRequested{true}, m_fullscreen{false}, m_redrawEventType{0}, m_redrawTimer{0},
+    m_titleDirty{false}
 {
     init();
 }
 
 MWindow::~MWindow() {
+    setRedrawInterval(0);
+
     if(!m_window) {
         SDL_DestroyWindow(m_window);
         m_window = nullptr;
@@ -23,17 +28,18 @@ MWindow::~MWindow() {
 }
 
 void MWindow::init() {
-    Uint32 subsystems = SDL_INIT_VIDEO;
+    Uint32 subsystems = SDL_INIT_VIDEO | SDL_INIT_TIMER;
     if(SDL_Init(subsystems) < 0) {
         std::string error = SDL_GetError();			
 	    throw std::runtime_error("Failed to initialize SDL: " + error);    
     }
 
     Uint32 options = SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE;
+    VkExtent2D extent = getExtent();
     m_window = SDL_CreateWindow(
         m_windowTitle.c_str(),
         SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-        m_width, m_height, options
+        static_cast<int>(extent.width), static_cast<int>(extent.height), options
     );
 
     if(!m_window) {
@@ -46,9 +52,79 @@ void MWindow::init() {
     // 0 imageView dimension triggers validation layer error
     SDL_SetWindowMinimumSize(m_window, 256, 144);
     SDL_AddEventWatch(resizingEventWatcher, m_window);
+
+    // user event pushed by the redraw timer, wakes up a loop blocked in processEvents
+    m_redrawEventType = SDL_RegisterEvents(1);
+    if (m_redrawEventType == static_cast<Uint32>(-1)) {
+        throw std::runtime_error("Failed to register SDL redraw event.");
+    }
+}
+
+void MWindow::processEvents(bool block, int timeoutMs) {
+    SDL_Event e;
+
+    // the listener runs after the window state is updated, so whoever it wakes sees the new state
+    if (block && SDL_WaitEventTimeout(&e, timeoutMs) != 0) {
+        handleEvent(e);
+        if (m_eventListener) {
+            m_eventListener(e);
+        }
+    }
+
+    while (SDL_PollEvent(&e) != 0) {
+        handleEvent(e);
+        if (m_eventListener) {
+            m_eventListener(e);
+        }
+    }
+
+    // SDL window calls belong to this thread, titles set from elsewhere are applied here
+    if (m_titleDirty.exchange(false, std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(m_titleMutex);
+        SDL_SetWindowTitle(m_window, m_pendingTitle.c_str());
+    }
+}
+
+void MWindow::requestClose() {
+    m_quit = true;
+
+    SDL_Event event {};
+    event.type = SDL_QUIT;
+    SDL_PushEvent(&event);
+}
+
+void MWindow::setRedrawInterval(uint32_t milliseconds) {
+    if (m_redrawTimer != 0) {
+        SDL_RemoveTimer(m_redrawTimer);
+        m_redrawTimer = 0;
+    }
+
+    if (milliseconds > 0) {
+        m_redrawTimer = SDL_AddTimer(milliseconds, redrawTimerCallback, this);
+        if (m_redrawTimer == 0) {
+            std::string error = SDL_GetError();
+            throw std::runtime_error("Failed to create redraw timer: " + error);
+        }
+    }
+}
+
+Uint32 MWindow::redrawTimerCallback(Uint32 interval, void* data) {
+    // runs on the SDL timer thread: only push an event, the loop thread does the rest
+    MWindow* window = static_cast<MWindow*>(data);
+
+    SDL_Event event {};
+    event.type = window->m_redrawEventType;
+    SDL_PushEvent(&event);
+
+    return interval; // keep repeating
 }
 
 void MWindow::handleEvent(SDL_Event& e) {
+    if (e.type == m_redrawEventType) {
+        m_redrawRequested = true;
+        return;
+    }
+
     switch (e.type) 
     {
     case SDL_QUIT:
@@ -58,31 +134,39 @@ void MWindow::handleEvent(SDL_Event& e) {
     case SDL_WINDOWEVENT:
         switch (e.window.event) 
         {
+        case SDL_WINDOWEVENT_SHOWN:
+        case SDL_WINDOWEVENT_EXPOSED:
+            m_redrawRequested = true;
+            break;
         case SDL_WINDOWEVENT_SIZE_CHANGED:
             break;
         case SDL_WINDOWEVENT_RESIZED:
-            m_width =  e.window.data1;  
-            m_height = e.window.data2;
+            m_extent.store(packExtent(e.window.data1, e.window.data2), std::memory_order_release);
             m_framebufferResized = true;
-            std::cout << "resized\n";
+            m_redrawRequested = true;
+            MOO_LOG_DEBUG("resized");
             break; 
         case SDL_WINDOWEVENT_MINIMIZED:
             m_minimized = true;
-            std::cout << "minimized\n";
+            MOO_LOG_DEBUG("minimized");
             break;
         case SDL_WINDOWEVENT_MAXIMIZED:
             m_minimized = false;
-            std::cout << "maximized\n";
+            m_redrawRequested = true;
+            MOO_LOG_DEBUG("maximized");
             break;
         case SDL_WINDOWEVENT_RESTORED:
             m_minimized = false;
-            std::cout << "restored\n";
+            m_redrawRequested = true;
+            MOO_LOG_DEBUG("restored");
             break;
 
         default:
             break;
         }
+        break; // window event data must not be read as a key event below
     case SDL_KEYDOWN:
+        m_redrawRequested = true;
         switch (e.key.keysym.sym)
         {
         case SDLK_RETURN:
@@ -99,6 +183,13 @@ void MWindow::handleEvent(SDL_Event& e) {
         default:
             break;
         }
+        break;
+    case SDL_KEYUP:
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+    case SDL_MOUSEWHEEL:
+        m_redrawRequested = true;
+        break;
 
     default:
         break;
@@ -112,14 +203,20 @@ void MWindow::createWindowSurface(VkInstance instance, VkSurfaceKHR *surface) {
     }
 }
 
+void MWindow::setTitleOverlay(const std::string& text) {
+    std::lock_guard<std::mutex> lock(m_titleMutex);
+    m_pendingTitle = text.empty() ? m_windowTitle : m_windowTitle + " | " + text;
+    m_titleDirty.store(true, std::memory_order_release);
+}
+
 int MWindow::resizingEventWatcher(void* data, SDL_Event* event) {
     if (event->type == SDL_WINDOWEVENT && event->window.event == SDL_WINDOWEVENT_RESIZED) {
         SDL_Window* win = SDL_GetWindowFromID(event->window.windowID);
         if (win == (SDL_Window*)data) {
             if (event->window.data1 < 2 || event->window.data2 < 2) {
-                std::cout << "width: " << event->window.data1 << "; height: " << event->window.data2 << "\n";
+                MOO_LOG_DEBUG("width: %d; height: %d", event->window.data1, event->window.data2);
             }
-            std::cout << "resizing.....\n";
+            MOO_LOG_TRACE("resizing.....");
         }
     }
     return 0;
@@ -0,0 +1,252 @@
+#include "VulkanBindlessTable.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+using namespace moo;
+
+VulkanBindlessTable::Capacity VulkanBindlessTable::enableFeatures(VkPhysicalDevice gpu, VkPhysicalDeviceVulkan12Features& features) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(gpu, &properties);
+    if (properties.apiVersion < VK_API_VERSION_1_2) {
+        return {};
+    }
+
+    VkPhysicalDeviceVulkan12Features supported {};
+    supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    VkPhysicalDeviceFeatures2 features2 {};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &supported;
+    vkGetPhysicalDeviceFeatures2(gpu, &features2);
+
+    // all or nothing: a table without one of them isn't usable
+    bool descriptorIndexing = supported.runtimeDescriptorArray &&
+        supported.descriptorBindingPartiallyBound &&
+        supported.descriptorBindingUpdateUnusedWhilePending &&
+        supported.descriptorBindingSampledImageUpdateAfterBind &&
+        supported.descriptorBindingStorageBufferUpdateAfterBind &&
+        supported.shaderSampledImageArrayNonUniformIndexing &&
+        supported.shaderStorageBufferArrayNonUniformIndexing;
+    if (!descriptorIndexing) {
+        return {};
+    }
+
+    features.descriptorIndexing = VK_TRUE;
+    features.runtimeDescriptorArray = VK_TRUE;
+    features.descriptorBindingPartiallyBound = VK_TRUE;
+    features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    features.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+
+    VkPhysicalDeviceVulkan12Properties limits {};
+    limits.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties2 {};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &limits;
+    vkGetPhysicalDeviceProperties2(gpu, &properties2);
+
+    Capacity capacity {};
+    // combined image samplers count as a sampled image and a sampler each
+    capacity.textures = std::min({MAX_TEXTURES,
+        limits.maxDescriptorSetUpdateAfterBindSampledImages, limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+        limits.maxDescriptorSetUpdateAfterBindSamplers, limits.maxPerStageDescriptorUpdateAfterBindSamplers});
+    capacity.buffers = std::min({MAX_BUFFERS,
+        limits.maxDescriptorSetUpdateAfterBindStorageBuffers, limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+
+    // both arrays are visible to every stage: together within the per-stage resource limit
+    uint32_t resources = limits.maxPerStageUpdateAfterBindResources;
+    if (capacity.textures + capacity.buffers > resources) {
+        capacity.buffers = std::min(capacity.buffers, resources / 2);
+        capacity.textures = std::min(capacity.textures, resources - capacity.buffers);
+    }
+    return capacity;
+}
+
+VulkanBindlessTable::VulkanBindlessTable(VkDevice device, Capacity capacity, uint32_t framesInFlight) :
+    m_device{device}, m_capacity{capacity}, m_framesInFlight{framesInFlight}
+{
+    assert(capacity.textures > 0 && capacity.buffers > 0 && "Bindless table without descriptor indexing.");
+    m_textures.capacity = capacity.textures;
+    m_buffers.capacity = capacity.buffers;
+
+    createSetLayout();
+    createSet();
+}
+
+VulkanBindlessTable::~VulkanBindlessTable() {
+    // frees m_set
+    vkDestroyDescriptorPool(m_device, m_pool, nullptr);
+    vkDestroyDescriptorSetLayout(m_device, m_setLayout, nullptr);
+}
+
+void VulkanBindlessTable::beginFrame() {
+    m_frame++;
+    if (m_frame >= m_framesInFlight) {
+        m_textures.recycle(m_frame - m_framesInFlight);
+        m_buffers.recycle(m_frame - m_framesInFlight);
+    }
+}
+
+uint32_t VulkanBindlessTable::addTexture(VkImageView view, VkSampler sampler, VkImageLayout layout) {
+    uint32_t index = m_textures.allocate();
+    if (index == INVALID_INDEX) {
+        return INVALID_INDEX;
+    }
+
+    VkDescriptorImageInfo imageInfo {};
+    imageInfo.sampler = sampler;
+    imageInfo.imageView = view;
+    imageInfo.imageLayout = layout;
+
+    VkWriteDescriptorSet write {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_set;
+    write.dstBinding = TEXTURE_BINDING;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+    vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+
+    return index;
+}
+
+uint32_t VulkanBindlessTable::addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+    uint32_t index = m_buffers.allocate();
+    if (index == INVALID_INDEX) {
+        return INVALID_INDEX;
+    }
+
+    VkDescriptorBufferInfo bufferInfo {};
+    bufferInfo.buffer = buffer;
+    bufferInfo.offset = offset;
+    bufferInfo.range = range;
+
+    VkWriteDescriptorSet write {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = m_set;
+    write.dstBinding = BUFFER_BINDING;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(m_device, 1, &write, 0, nullptr);
+
+    return index;
+}
+
+void VulkanBindlessTable::removeTexture(uint32_t index) {
+    // the descriptor stays written: frames in flight may still read it
+    m_textures.release(index, m_frame);
+}
+
+void VulkanBindlessTable::removeBuffer(uint32_t index) {
+    m_buffers.release(index, m_frame);
+}
+
+void VulkanBindlessTable::bind(VulkanCommandEncoder& encoder, VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t set) {
+    encoder.bindDescriptorSets(bindPoint, layout, set, 1, &m_set);
+}
+
+VulkanBindlessTable::Stats VulkanBindlessTable::getStats() const {
+    Stats stats {};
+    stats.textures = m_textures.live();
+    stats.buffers = m_buffers.live();
+    return stats;
+}
+
+void VulkanBindlessTable::createSetLayout() {
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings {};
+    bindings[0].binding = TEXTURE_BINDING;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = m_capacity.textures;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+    bindings[1].binding = BUFFER_BINDING;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = m_capacity.buffers;
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+    // binding flags aren't part of the layout cache key: the table owns its layout
+    VkDescriptorBindingFlags flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    std::array<VkDescriptorBindingFlags, 2> bindingFlags = {flags, flags};
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo {};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+    bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo {};
+    setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.pNext = &bindingFlagsInfo;
+    setLayoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    setLayoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    setLayoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(m_device, &setLayoutInfo, nullptr, &m_setLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create bindless descriptor set layout.");
+    }
+}
+
+void VulkanBindlessTable::createSet() {
+    std::array<VkDescriptorPoolSize, 2> poolSizes = {{
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_capacity.textures},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_capacity.buffers},
+    }};
+
+    VkDescriptorPoolCreateInfo poolInfo {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    if (vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_pool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create bindless descriptor pool.");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &m_setLayout;
+
+    if (vkAllocateDescriptorSets(m_device, &allocInfo, &m_set) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate bindless descriptor set.");
+    }
+}
+
+uint32_t VulkanBindlessTable::IndexAllocator::allocate() {
+    if (!free.empty()) {
+        uint32_t index = free.back();
+        free.pop_back();
+        return index;
+    }
+    if (next < capacity) {
+        return next++;
+    }
+    return INVALID_INDEX;
+}
+
+void VulkanBindlessTable::IndexAllocator::release(uint32_t index, uint64_t frame) {
+    assert(index < next && "Bindless index was never allocated.");
+    retired.emplace_back(index, frame);
+}
+
+void VulkanBindlessTable::IndexAllocator::recycle(uint64_t completedFrame) {
+    // retired in frame order: the completed ones are a prefix
+    auto completed = std::find_if(retired.begin(), retired.end(),
+        [completedFrame](const std::pair<uint32_t, uint64_t>& entry) { return entry.second > completedFrame; });
+    for (auto it = retired.begin(); it != completed; ++it) {
+        free.push_back(it->first);
+    }
+    retired.erase(retired.begin(), completed);
+}
+
+uint32_t VulkanBindlessTable::IndexAllocator::live() const {
+    return next - static_cast<uint32_t>(free.size() + retired.size());
+}
@@ -0,0 +1,192 @@
+#include "VulkanCommandEncoder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+
+using namespace moo;
+
+uint32_t VulkanCommandEncoder::Stats::totalIssued() const {
+    return std::accumulate(issued.begin(), issued.end(), 0u);
+}
+
+uint32_t VulkanCommandEncoder::Stats::totalElided() const {
+    return std::accumulate(elided.begin(), elided.end(), 0u);
+}
+
+uint32_t VulkanCommandEncoder::dynamicStatesOf(const std::vector<VkDynamicState>& dynamicStates) {
+    auto has = [&dynamicStates](VkDynamicState state) {
+        return std::find(dynamicStates.begin(), dynamicStates.end(), state) != dynamicStates.end();
+    };
+
+    uint32_t flags = 0;
+    if (has(VK_DYNAMIC_STATE_VIEWPORT)) {
+        flags |= DynamicViewport;
+    }
+    if (has(VK_DYNAMIC_STATE_SCISSOR)) {
+        flags |= DynamicScissor;
+    }
+    if (std::all_of(VulkanDynamicState::DYNAMIC_STATES.begin(), VulkanDynamicState::DYNAMIC_STATES.end(), has)) {
+        flags |= DynamicExtended;
+    }
+    return flags;
+}
+
+void VulkanCommandEncoder::begin(VkCommandBuffer commandBuffer) {
+    m_commandBuffer = commandBuffer;
+    m_dynamicState.begin(commandBuffer);
+    invalidate();
+
+    m_stats = Stats{};
+    m_dynamicRecorded = m_dynamicState.getRecordedCount();
+    m_dynamicSkipped = m_dynamicState.getSkippedCount();
+}
+
+void VulkanCommandEncoder::invalidate() {
+    m_dynamicState.invalidate();
+
+    m_bindPoints = {};
+    m_vertexBindings = {};
+    m_indexBuffer = VK_NULL_HANDLE;
+    m_pushConstants.layout = VK_NULL_HANDLE;
+    m_viewportSet = false;
+    m_scissorSet = false;
+}
+
+void VulkanCommandEncoder::bindPipeline(VkPipelineBindPoint bindPoint, VkPipeline pipeline, uint32_t dynamicStates) {
+    BindPointState& state = bindPointState(bindPoint);
+    bool issue = state.pipeline != pipeline;
+    if (issue) {
+        vkCmdBindPipeline(m_commandBuffer, bindPoint, pipeline);
+        state.pipeline = pipeline;
+
+        // states baked in the pipeline replaced what was set
+        if (bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS) {
+            if ((dynamicStates & DynamicViewport) == 0) {
+                m_viewportSet = false;
+            }
+            if ((dynamicStates & DynamicScissor) == 0) {
+                m_scissorSet = false;
+            }
+            if ((dynamicStates & DynamicExtended) == 0) {
+                m_dynamicState.invalidate();
+            }
+        }
+    }
+    count(Command::Pipeline, issue);
+}
+
+void VulkanCommandEncoder::bindVertexBuffers(uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* buffers, const VkDeviceSize* offsets) {
+    bool issue = firstBinding + bindingCount > MAX_VERTEX_BINDINGS;
+    for (uint32_t i = 0; i < bindingCount && !issue; i++) {
+        const VertexBinding& bound = m_vertexBindings[firstBinding + i];
+        issue = bound.buffer != buffers[i] || bound.offset != offsets[i];
+    }
+
+    if (issue) {
+        vkCmdBindVertexBuffers(m_commandBuffer, firstBinding, bindingCount, buffers, offsets);
+        for (uint32_t i = 0; i < bindingCount && firstBinding + i < MAX_VERTEX_BINDINGS; i++) {
+            m_vertexBindings[firstBinding + i] = {buffers[i], offsets[i]};
+        }
+    }
+    count(Command::VertexBuffers, issue);
+}
+
+void VulkanCommandEncoder::bindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType) {
+    bool issue = m_indexBuffer != buffer || m_indexOffset != offset || m_indexType != indexType;
+    if (issue) {
+        vkCmdBindIndexBuffer(m_commandBuffer, buffer, offset, indexType);
+        m_indexBuffer = buffer;
+        m_indexOffset = offset;
+        m_indexType = indexType;
+    }
+    count(Command::IndexBuffer, issue);
+}
+
+void VulkanCommandEncoder::bindDescriptorSets(VkPipelineBindPoint bindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t setCount,
+    const VkDescriptorSet* sets, uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets)
+{
+    BindPointState& state = bindPointState(bindPoint);
+
+    bool issue = dynamicOffsetCount > 0 || state.layout != layout || firstSet + setCount > MAX_DESCRIPTOR_SETS;
+    for (uint32_t i = 0; i < setCount && !issue; i++) {
+        issue = state.sets[firstSet + i] != sets[i];
+    }
+
+    if (issue) {
+        vkCmdBindDescriptorSets(m_commandBuffer, bindPoint, layout, firstSet, setCount, sets, dynamicOffsetCount, dynamicOffsets);
+        // another layout may have disturbed the other sets: only the ones just bound are known
+        if (state.layout != layout) {
+            state.sets = {};
+            state.layout = layout;
+        }
+        for (uint32_t i = 0; i < setCount && firstSet + i < MAX_DESCRIPTOR_SETS; i++) {
+            // with dynamic offsets, the set alone doesn't say what is bound
+            state.sets[firstSet + i] = dynamicOffsetCount > 0 ? VK_NULL_HANDLE : sets[i];
+        }
+    }
+    count(Command::DescriptorSets, issue);
+}
+
+void VulkanCommandEncoder::pushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data) {
+    PushConstantBlock& block = m_pushConstants;
+    bool tracked = size <= MAX_PUSH_CONSTANT_SIZE;
+
+    bool issue = !tracked || block.layout != layout || block.stages != stages || block.offset != offset || block.size != size ||
+        std::memcmp(block.data.data(), data, size) != 0;
+
+    if (issue) {
+        vkCmdPushConstants(m_commandBuffer, layout, stages, offset, size, data);
+        if (tracked) {
+            block.layout = layout;
+            block.stages = stages;
+            block.offset = offset;
+            block.size = size;
+            std::memcpy(block.data.data(), data, size);
+        } else {
+            block.layout = VK_NULL_HANDLE;
+        }
+    }
+    count(Command::PushConstants, issue);
+}
+
+void VulkanCommandEncoder::setViewport(const VkViewport& viewport) {
+    bool issue = !m_viewportSet || std::memcmp(&m_viewport, &viewport, sizeof(VkViewport)) != 0;
+    if (issue) {
+        vkCmdSetViewport(m_commandBuffer, 0, 1, &viewport);
+        m_viewport = viewport;
+        m_viewportSet = true;
+    }
+    count(Command::Viewport, issue);
+}
+
+void VulkanCommandEncoder::setScissor(const VkRect2D& scissor) {
+    bool issue = !m_scissorSet || std::memcmp(&m_scissor, &scissor, sizeof(VkRect2D)) != 0;
+    if (issue) {
+        vkCmdSetScissor(m_commandBuffer, 0, 1, &scissor);
+        m_scissor = scissor;
+        m_scissorSet = true;
+    }
+    count(Command::Scissor, issue);
+}
+
+VulkanCommandEncoder::Stats VulkanCommandEncoder::getStats() const {
+    Stats stats = m_stats;
+    stats.issued[static_cast<size_t>(Command::DynamicState)] = static_cast<uint32_t>(m_dynamicState.getRecordedCount() - m_dynamicRecorded);
+    stats.elided[static_cast<size_t>(Command::DynamicState)] = static_cast<uint32_t>(m_dynamicState.getSkippedCount() - m_dynamicSkipped);
+    return stats;
+}
+
+VulkanCommandEncoder::BindPointState& VulkanCommandEncoder::bindPointState(VkPipelineBindPoint bindPoint) {
+    assert((bindPoint == VK_PIPELINE_BIND_POINT_GRAPHICS || bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE) && "Unsupported pipeline bind point.");
+    return m_bindPoints[bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? 1 : 0];
+}
+
+void VulkanCommandEncoder::count(Command command, bool issued) {
+    if (issued) {
+        m_stats.issued[static_cast<size_t>(command)]++;
+    } else {
+        m_stats.elided[static_cast<size_t>(command)]++;
+    }
+}
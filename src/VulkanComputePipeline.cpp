@@ -0,0 +1,192 @@
+#include "VulkanComputePipeline.h"
+
+#include "vk_initializers.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace moo;
+
+VulkanComputePipeline::VulkanComputePipeline(VulkanDevice& device, const std::string& compFilepath, const ComputeConfigInfo& configInfo) :
+    m_device{device}, m_bindings{configInfo.bindings}, m_pushConstantSize{configInfo.pushConstantSize}
+{
+    createLayout(configInfo);
+    createDescriptorPool(configInfo);
+    createPipeline(compFilepath, configInfo);
+}
+
+VulkanComputePipeline::~VulkanComputePipeline() {
+    // shader module belongs to the device shader cache
+    vkDestroyPipeline(m_device.getDevice(), m_pipeline, nullptr);
+    vkDestroyPipelineLayout(m_device.getDevice(), m_pipelineLayout, nullptr);
+    // frees the sets allocated from it
+    vkDestroyDescriptorPool(m_device.getDevice(), m_descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(m_device.getDevice(), m_descriptorSetLayout, nullptr);
+}
+
+void VulkanComputePipeline::createLayout(const ComputeConfigInfo& configInfo) {
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo {};
+    setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = static_cast<uint32_t>(configInfo.bindings.size());
+    setLayoutInfo.pBindings = configInfo.bindings.data();
+
+    if (vkCreateDescriptorSetLayout(m_device.getDevice(), &setLayoutInfo, nullptr, &m_descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create compute descriptor set layout.");
+    }
+
+    VkPushConstantRange pushConstantRange {};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = configInfo.pushConstantSize;
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = vkinit::pipelineLayoutCreateInfo();
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &m_descriptorSetLayout;
+    if (configInfo.pushConstantSize > 0) {
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    }
+
+    if (vkCreatePipelineLayout(m_device.getDevice(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create compute pipeline layout.");
+    }
+}
+
+void VulkanComputePipeline::createDescriptorPool(const ComputeConfigInfo& configInfo) {
+    // exactly what maxDescriptorSets sets of this layout need
+    std::unordered_map<VkDescriptorType, uint32_t> descriptorCounts;
+    for (const VkDescriptorSetLayoutBinding& binding : configInfo.bindings) {
+        descriptorCounts[binding.descriptorType] += binding.descriptorCount * configInfo.maxDescriptorSets;
+    }
+
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for (const auto& [type, count] : descriptorCounts) {
+        poolSizes.push_back({type, count});
+    }
+    if (poolSizes.empty()) {
+        return;
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = configInfo.maxDescriptorSets;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    if (vkCreateDescriptorPool(m_device.getDevice(), &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create compute descriptor pool.");
+    }
+}
+
+void VulkanComputePipeline::createPipeline(const std::string& compFilepath, const ComputeConfigInfo& configInfo) {
+    VkPipelineShaderStageCreateInfo stageInfo = m_device.getShaderCache().getStageInfo(compFilepath, VK_SHADER_STAGE_COMPUTE_BIT);
+
+    VkSpecializationInfo specializationInfo = configInfo.specialization.getInfo();
+    if (!configInfo.specialization.empty()) {
+        stageInfo.pSpecializationInfo = &specializationInfo;
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo = vkinit::computePipelineCreateInfo(stageInfo, m_pipelineLayout);
+
+    if (vkCreateComputePipelines(m_device.getDevice(), m_device.getPipelineCache().getCache(), 1, &pipelineInfo, nullptr, &m_pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create compute pipeline.");
+    }
+}
+
+VkDescriptorSet VulkanComputePipeline::allocateDescriptorSet() {
+    assert(m_descriptorPool != VK_NULL_HANDLE && "Cannot allocate descriptor set: the compute pipeline has no bindings.");
+
+    VkDescriptorSetAllocateInfo allocInfo {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = m_descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &m_descriptorSetLayout;
+
+    VkDescriptorSet set;
+    if (vkAllocateDescriptorSets(m_device.getDevice(), &allocInfo, &set) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate compute descriptor set: maxDescriptorSets reached.");
+    }
+
+    return set;
+}
+
+void VulkanComputePipeline::writeBuffer(VkDescriptorSet set, uint32_t binding, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+    auto found = std::find_if(m_bindings.begin(), m_bindings.end(),
+        [binding](const VkDescriptorSetLayoutBinding& b) { return b.binding == binding; });
+    assert(found != m_bindings.end() && "Cannot write descriptor: binding not in the compute layout.");
+
+    VkDescriptorBufferInfo bufferInfo {};
+    bufferInfo.buffer = buffer;
+    bufferInfo.offset = offset;
+    bufferInfo.range = range;
+
+    VkWriteDescriptorSet write = vkinit::writeDescriptorBuffer(found->descriptorType, set, &bufferInfo, binding);
+    vkUpdateDescriptorSets(m_device.getDevice(), 1, &write, 0, nullptr);
+}
+
+void VulkanComputePipeline::bind(VkCommandBuffer commandBuffer) {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+}
+
+void VulkanComputePipeline::bindDescriptorSet(VkCommandBuffer commandBuffer, VkDescriptorSet set) {
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &set, 0, nullptr);
+}
+
+void VulkanComputePipeline::pushConstants(VkCommandBuffer commandBuffer, const void* data, uint32_t size) {
+    assert(size <= m_pushConstantSize && "Cannot push constants: larger than configInfo.pushConstantSize.");
+    vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, size, data);
+}
+
+void VulkanComputePipeline::dispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) {
+    vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+}
+
+void VulkanComputePipeline::dispatchElements(VkCommandBuffer commandBuffer, uint32_t elementCount, uint32_t localSizeX) {
+    if (elementCount == 0) {
+        return;
+    }
+    vkCmdDispatch(commandBuffer, groupCount(elementCount, localSizeX), 1, 1);
+}
+
+void VulkanComputePipeline::dispatchIndirect(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset) {
+    vkCmdDispatchIndirect(commandBuffer, buffer, offset);
+}
+
+void VulkanComputePipeline::barrier(VkCommandBuffer commandBuffer, VkBuffer buffer, Consumer consumer, VkDeviceSize offset, VkDeviceSize size) {
+    VkPipelineStageFlags dstStage = 0;
+    VkAccessFlags dstAccess = 0;
+    switch (consumer) {
+    case Consumer::Compute:
+        dstStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        dstAccess = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        break;
+    case Consumer::VertexInput:
+        dstStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        dstAccess = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+        break;
+    case Consumer::VertexShader:
+        dstStage = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+        dstAccess = VK_ACCESS_SHADER_READ_BIT;
+        break;
+    case Consumer::Indirect:
+        // the command reading the arguments runs before the dispatch/draw itself
+        dstStage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+        dstAccess = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        break;
+    case Consumer::Transfer:
+        dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        dstAccess = VK_ACCESS_TRANSFER_READ_BIT;
+        break;
+    case Consumer::Host:
+        dstStage = VK_PIPELINE_STAGE_HOST_BIT;
+        dstAccess = VK_ACCESS_HOST_READ_BIT;
+        break;
+    default:
+        throw std::runtime_error("Invalid compute barrier consumer.");
+    }
+
+    VkBufferMemoryBarrier bufferBarrier = vkinit::bufferMemoryBarrier(buffer, VK_ACCESS_SHADER_WRITE_BIT, dstAccess, offset, size);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dstStage, 0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+}
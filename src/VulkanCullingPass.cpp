@@ -0,0 +1,189 @@
+#include "VulkanCullingPass.h"
+
+#include "vk_initializers.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace moo;
+
+namespace {
+
+constexpr VkDeviceSize DRAW_STRIDE = sizeof(VkDrawIndexedIndirectCommand);
+
+}   // namespace
+
+VulkanComputePipeline::ComputeConfigInfo VulkanCullingPass::configInfo(VulkanDevice& device, uint32_t slots) {
+    VulkanComputePipeline::ComputeConfigInfo info {};
+    info.bindings = {
+        vkinit::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 0),
+        vkinit::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1),
+        vkinit::descriptorSetLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 2),
+    };
+    info.pushConstantSize = sizeof(CullConstants);
+    info.maxDescriptorSets = slots;
+    info.specialization.set(0, LOCAL_SIZE).set(1, device.isDrawIndirectCountEnabled());
+    return info;
+}
+
+bool VulkanCullingPass::isSupported(VulkanDevice& device, uint32_t capacity) {
+    const VkPhysicalDeviceProperties& properties = device.m_deviceProperties;
+    if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU) {
+        return false;
+    }
+    // objects and draws are each bound whole
+    if (sizeof(Object) * static_cast<VkDeviceSize>(capacity) > properties.limits.maxStorageBufferRange) {
+        return false;
+    }
+
+    std::ifstream shader(CULL_SHADER_FILE, std::ios::binary);
+    return shader.good();
+}
+
+VulkanCullingPass::VulkanCullingPass(VulkanDevice& device, uint32_t capacity, uint32_t slots) :
+    m_device{device},
+    m_pipeline{device, CULL_SHADER_FILE, configInfo(device, slots)},
+    m_compact{device.isDrawIndirectCountEnabled()},
+    m_capacity{capacity},
+    m_slots(slots)
+{
+    assert(capacity > 0 && slots > 0 && "Cannot create an empty culling pass.");
+
+    m_device.createBuffer(sizeof(Object) * static_cast<VkDeviceSize>(capacity),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        m_objectBuffer, m_objectMemory
+    );
+
+    // written and read by the GPU only: device local, cleared with vkCmdFillBuffer
+    for (Slot& slot : m_slots) {
+        m_device.createBuffer(DRAW_STRIDE * capacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            slot.drawBuffer, slot.drawMemory
+        );
+        m_device.createBuffer(sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            slot.countBuffer, slot.countMemory
+        );
+
+        slot.descriptorSet = m_pipeline.allocateDescriptorSet();
+        m_pipeline.writeBuffer(slot.descriptorSet, 0, m_objectBuffer);
+        m_pipeline.writeBuffer(slot.descriptorSet, 1, slot.drawBuffer);
+        m_pipeline.writeBuffer(slot.descriptorSet, 2, slot.countBuffer);
+    }
+}
+
+VulkanCullingPass::~VulkanCullingPass() {
+    for (Slot& slot : m_slots) {
+        vkDestroyBuffer(m_device.getDevice(), slot.drawBuffer, nullptr);
+        vkFreeMemory(m_device.getDevice(), slot.drawMemory, nullptr);
+        vkDestroyBuffer(m_device.getDevice(), slot.countBuffer, nullptr);
+        vkFreeMemory(m_device.getDevice(), slot.countMemory, nullptr);
+    }
+    vkDestroyBuffer(m_device.getDevice(), m_objectBuffer, nullptr);
+    vkFreeMemory(m_device.getDevice(), m_objectMemory, nullptr);
+}
+
+uint32_t VulkanCullingPass::setObjects(const std::vector<Object>& objects) {
+    m_objectCount = std::min(static_cast<uint32_t>(objects.size()), m_capacity);
+    if (m_objectCount == 0) {
+        return 0;
+    }
+
+    VkDeviceSize bufferSize = sizeof(Object) * static_cast<VkDeviceSize>(m_objectCount);
+
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    m_device.createBuffer(bufferSize,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        stagingBuffer, stagingBufferMemory
+    );
+
+    void* data;
+    vkMapMemory(m_device.getDevice(), stagingBufferMemory, 0, bufferSize, 0, &data);
+        memcpy(data, objects.data(), static_cast<size_t>(bufferSize));
+    vkUnmapMemory(m_device.getDevice(), stagingBufferMemory);
+
+    m_device.copyBuffer(stagingBuffer, m_objectBuffer, bufferSize);
+
+    vkDestroyBuffer(m_device.getDevice(), stagingBuffer, nullptr);
+    vkFreeMemory(m_device.getDevice(), stagingBufferMemory, nullptr);
+
+    return m_objectCount;
+}
+
+void VulkanCullingPass::cull(VkCommandBuffer commandBuffer, uint32_t slot, const glm::mat4& viewProjection) {
+    assert(slot < m_slots.size() && "Culling pass slot out of range.");
+    if (m_objectCount == 0) {
+        return;
+    }
+    const Slot& current = m_slots[slot];
+
+    if (m_compact) {
+        // the shader appends from 0: clear the counter, then let the dispatch touch it
+        vkCmdFillBuffer(commandBuffer, current.countBuffer, 0, sizeof(uint32_t), 0);
+        VkBufferMemoryBarrier clearBarrier = vkinit::bufferMemoryBarrier(current.countBuffer,
+            VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, 0, VK_WHOLE_SIZE);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 0, nullptr, 1, &clearBarrier, 0, nullptr);
+    }
+
+    CullConstants constants {};
+    constants.planes = extractFrustumPlanes(viewProjection);
+    constants.objectCount = m_objectCount;
+
+    m_pipeline.bind(commandBuffer);
+    m_pipeline.bindDescriptorSet(commandBuffer, current.descriptorSet);
+    m_pipeline.pushConstants(commandBuffer, constants);
+    m_pipeline.dispatchElements(commandBuffer, m_objectCount, LOCAL_SIZE);
+
+    VulkanComputePipeline::barrier(commandBuffer, current.drawBuffer, VulkanComputePipeline::Consumer::Indirect);
+    if (m_compact) {
+        VulkanComputePipeline::barrier(commandBuffer, current.countBuffer, VulkanComputePipeline::Consumer::Indirect);
+    }
+}
+
+void VulkanCullingPass::draw(VkCommandBuffer commandBuffer, uint32_t slot) {
+    assert(slot < m_slots.size() && "Culling pass slot out of range.");
+    if (m_objectCount == 0) {
+        return;
+    }
+    const Slot& current = m_slots[slot];
+
+    if (m_compact) {
+        vkCmdDrawIndexedIndirectCount(commandBuffer, current.drawBuffer, 0, current.countBuffer, 0,
+            m_objectCount, static_cast<uint32_t>(DRAW_STRIDE));
+    } else if (m_device.m_deviceFeatures.multiDrawIndirect) {
+        // culled objects are draws with no instance
+        vkCmdDrawIndexedIndirect(commandBuffer, current.drawBuffer, 0, m_objectCount, static_cast<uint32_t>(DRAW_STRIDE));
+    } else {
+        for (uint32_t i = 0; i < m_objectCount; i++) {
+            vkCmdDrawIndexedIndirect(commandBuffer, current.drawBuffer, DRAW_STRIDE * i, 1, static_cast<uint32_t>(DRAW_STRIDE));
+        }
+    }
+}
+
+std::array<glm::vec4, 6> VulkanCullingPass::extractFrustumPlanes(const glm::mat4& viewProjection) {
+    // rows of the column major matrix
+    glm::vec4 row0 {viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]};
+    glm::vec4 row1 {viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]};
+    glm::vec4 row2 {viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]};
+    glm::vec4 row3 {viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]};
+
+    // -w <= x, y <= w and 0 <= z <= w
+    std::array<glm::vec4, 6> planes = {row3 + row0, row3 - row0, row3 + row1, row3 - row1, row2, row3 - row2};
+    for (glm::vec4& plane : planes) {
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length > 0.0f) {
+            plane /= length;
+        }
+    }
+    return planes;
+}
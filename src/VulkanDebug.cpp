@@ -1,58 +1,158 @@
 #include "VulkanDebug.h"
 
-#include <string>
-#include <iostream>
-#include <sstream>
+#include "MLogger.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cassert>
 
 using namespace moo;
 
-VKAPI_ATTR VkBool32 VKAPI_CALL VulkanDebug::debugUtilsMessengerCallback(
-    VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
-    VkDebugUtilsMessageTypeFlagsEXT messageType,
-    const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
-    void* pUserData)
-{
-    // Select prefix depending on flags passed to the callback
-    std::string prefix("");
+namespace {
+
+// Fixed size open addressing table shared by every messenger: the callback can run on
+// any thread the driver calls from, so entries are claimed with a CAS on the key.
+struct MessageEntry {
+    std::atomic<uint64_t> key {0};      // 0 = empty slot
+    std::atomic<bool> ready {false};    // name/id published by the thread that claimed the slot
+    std::atomic<uint32_t> count {0};
+    uint32_t reported = 1;              // count at last summary (first occurrence is not a repeat), summary owner only
+    int32_t messageId = 0;
+    char name[64] = {};
+};
+
+constexpr uint32_t TABLE_SIZE = 4096;    // power of two
+constexpr uint32_t MAX_PROBES = 64;
+
+std::array<MessageEntry, TABLE_SIZE> s_messages;
+std::atomic<uint64_t> s_untracked {0};  // messages that found no free slot
+uint64_t s_untrackedReported = 0;
+std::atomic<bool> s_summaryBusy {false};
+
+// FNV-1a over the message id and every object handle involved
+uint64_t hashMessage(const VkDebugUtilsMessengerCallbackDataEXT* data) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            hash ^= (value >> (i * 8)) & 0xff;
+            hash *= 1099511628211ULL;
+        }
+    };
 
-    if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT) {
-        prefix = "VERBOSE: ";
+    mix(static_cast<uint32_t>(data->messageIdNumber));
+    for (uint32_t i = 0; i < data->objectCount; i++) {
+        mix(data->pObjects[i].objectHandle);
     }
-    else if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) {
-        prefix = "INFO: ";
+
+    return hash != 0 ? hash : 1;
+}
+
+// returns true only for the first occurrence of a message
+bool registerMessage(const VkDebugUtilsMessengerCallbackDataEXT* data) {
+    uint64_t key = hashMessage(data);
+
+    for (uint32_t probe = 0; probe < MAX_PROBES; probe++) {
+        MessageEntry& entry = s_messages[(key + probe) & (TABLE_SIZE - 1)];
+        uint64_t current = entry.key.load(std::memory_order_acquire);
+
+        if (current == 0) {
+            if (entry.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                entry.messageId = data->messageIdNumber;
+                const char* name = data->pMessageIdName ? data->pMessageIdName : "";
+                for (size_t i = 0; i < sizeof(entry.name) - 1 && name[i] != '\0'; i++) {
+                    entry.name[i] = name[i];
+                }
+                entry.ready.store(true, std::memory_order_release);
+                entry.count.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            // lost the race, current now holds the winner's key
+        }
+
+        if (current == key) {
+            // only the thread that claimed the slot reports the first occurrence
+            entry.count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
     }
-    else if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
-        prefix = "WARNING: ";
+
+    // table full: still print it, but count it so the summary shows the table overflowed
+    s_untracked.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+LogLevel toLogLevel(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity) {
+    if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
+        return LogLevel::Error;
     }
-    else if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
-        prefix = "ERROR: ";
+    if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
+        return LogLevel::Warning;
     }
+    if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) {
+        return LogLevel::Info;
+    }
+    return LogLevel::Debug;
+}
 
-    // Display message to default output (console/logcat)
-    std::stringstream debugMessage;
-    debugMessage << prefix << "[" << pCallbackData->messageIdNumber << "][" << pCallbackData->pMessageIdName << "] : " << pCallbackData->pMessage;
+}   // namespace
+
+VKAPI_ATTR VkBool32 VKAPI_CALL VulkanDebug::debugUtilsMessengerCallback(
+    VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
+    VkDebugUtilsMessageTypeFlagsEXT messageType,
+    const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+    void* pUserData)
+{
+    // a validation error repeated every draw must not cost a formatted line + flush per draw:
+    // only the first occurrence goes to the asynchronous logger, repeats are just counted
+    if (registerMessage(pCallbackData)) {
+        const char* idName = pCallbackData->pMessageIdName ? pCallbackData->pMessageIdName : "";
 
 #if defined(__ANDROID__)
-    if (messageSeverity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
-        LOGE("%s", debugMessage.str().c_str());
-    } else {
-        LOGD("%s", debugMessage.str().c_str());
-    }
+        if (messageSeverity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
+            LOGE("[%d][%s] : %s", pCallbackData->messageIdNumber, idName, pCallbackData->pMessage);
+        } else {
+            LOGD("[%d][%s] : %s", pCallbackData->messageIdNumber, idName, pCallbackData->pMessage);
+        }
 #else
-    if (messageSeverity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
-        std::cerr << debugMessage.str() << "\n";
-    } else {
-        std::cout << debugMessage.str() << "\n";
-    }
-    fflush(stdout);
+        MLogger::instance().log(toLogLevel(messageSeverity), "[%d][%s] : %s", pCallbackData->messageIdNumber, idName, pCallbackData->pMessage);
 #endif
+    }
 
     // The return value of this callback controls whether the Vulkan call that caused the validation message will be aborted or not
     // We return VK_FALSE as we DON'T want Vulkan calls that cause a validation message to abort
     // If you instead want to have calls abort, pass in VK_TRUE and the function will return VK_ERROR_VALIDATION_FAILED_EXT 
     return VK_FALSE;
 }
+
+void VulkanDebug::printSummary() {
+    // the summary walks the whole table, keep concurrent callers out
+    if (s_summaryBusy.exchange(true, std::memory_order_acquire)) {
+        return;
+    }
+
+    for (MessageEntry& entry : s_messages) {
+        if (!entry.ready.load(std::memory_order_acquire)) {
+            continue;
+        }
+
+        uint32_t count = entry.count.load(std::memory_order_relaxed);
+        if (count > 1 && count != entry.reported) {
+            MLogger::instance().log(LogLevel::Warning, "[%d][%s] repeated %u times (+%u since last summary)",
+                entry.messageId, entry.name, count - 1, count - entry.reported);
+            entry.reported = count;
+        }
+    }
+
+    uint64_t untracked = s_untracked.load(std::memory_order_relaxed);
+    if (untracked != s_untrackedReported) {
+        MLogger::instance().log(LogLevel::Warning, "%llu validation messages were not deduplicated: message table full",
+            static_cast<unsigned long long>(untracked));
+        s_untrackedReported = untracked;
+    }
+
+    s_summaryBusy.store(false, std::memory_order_release);
+}
     
 void VulkanDebug::setupDebugging(VkInstance instance) {
     // setup pointers to the VK_EXT_debug_utils commands
@@ -75,10 +175,15 @@ void VulkanDebug::setupDebugging(VkInstance instance) {
     
     VkResult result = CreateDebugUtilsMessengerEXT(instance, &debugMessenger_cInfo, nullptr, &m_debugMessenger);
     assert(result == VK_SUCCESS);
+
+    MLogger::instance().setPeriodicTask(&VulkanDebug::printSummary, std::chrono::seconds(SUMMARY_INTERVAL_SECONDS));
 }
 
 void VulkanDebug::freeDebugCallback(VkInstance instance) {
     if (m_debugMessenger != VK_NULL_HANDLE) {
         DestroyDebugUtilsMessengerEXT(instance, m_debugMessenger, nullptr);
     }
+
+    MLogger::instance().setPeriodicTask({}, std::chrono::milliseconds(0));
+    printSummary();
 }
\ No newline at end of file
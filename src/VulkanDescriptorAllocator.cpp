@@ -0,0 +1,191 @@
+#include "VulkanDescriptorAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+using namespace moo;
+
+namespace {
+
+// uniforms and textures first, storage for compute
+const std::vector<VulkanDescriptorAllocator::PoolSizeRatio> DEFAULT_RATIOS = {
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+    {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f},
+};
+
+}   // namespace
+
+VulkanDescriptorAllocator::VulkanDescriptorAllocator(VkDevice device, VulkanLayoutCache& layoutCache, uint32_t frames) :
+    VulkanDescriptorAllocator(device, layoutCache, frames, DEFAULT_RATIOS) {}
+
+VulkanDescriptorAllocator::VulkanDescriptorAllocator(VkDevice device, VulkanLayoutCache& layoutCache, uint32_t frames, std::vector<PoolSizeRatio> ratios) :
+    m_device{device}, m_layoutCache{layoutCache}, m_ratios{std::move(ratios)}, m_minCounts(m_ratios.size(), 1), m_frames(frames)
+{
+    assert(frames > 0 && "Descriptor allocator needs at least one frame.");
+}
+
+VulkanDescriptorAllocator::~VulkanDescriptorAllocator() {
+    // frees every set allocated from them
+    auto destroy = [this](Pools& pools) {
+        for (VkDescriptorPool pool : pools.ready) {
+            vkDestroyDescriptorPool(m_device, pool, nullptr);
+        }
+        for (VkDescriptorPool pool : pools.full) {
+            vkDestroyDescriptorPool(m_device, pool, nullptr);
+        }
+        for (VkDescriptorPool pool : pools.stale) {
+            vkDestroyDescriptorPool(m_device, pool, nullptr);
+        }
+    };
+
+    for (Pools& pools : m_frames) {
+        destroy(pools);
+    }
+    destroy(m_persistent);
+}
+
+void VulkanDescriptorAllocator::beginFrame(uint32_t frame) {
+    assert(frame < m_frames.size() && "Descriptor allocator frame out of range.");
+    m_frame = frame;
+
+    Pools& pools = m_frames[frame];
+    for (VkDescriptorPool pool : pools.ready) {
+        vkResetDescriptorPool(m_device, pool, 0);
+    }
+    for (VkDescriptorPool pool : pools.full) {
+        vkResetDescriptorPool(m_device, pool, 0);
+        pools.ready.push_back(pool);
+    }
+    pools.full.clear();
+    // their sets went with the frame
+    for (VkDescriptorPool pool : pools.stale) {
+        vkDestroyDescriptorPool(m_device, pool, nullptr);
+    }
+    pools.stale.clear();
+    pools.allocated = 0;
+}
+
+VkDescriptorSet VulkanDescriptorAllocator::allocate(VkDescriptorSetLayout layout) {
+    return allocate(m_frames[m_frame], layout);
+}
+
+VkDescriptorSet VulkanDescriptorAllocator::allocate(std::vector<VkDescriptorSetLayoutBinding> bindings) {
+    return allocate(m_frames[m_frame], m_layoutCache.getSetLayout(std::move(bindings)));
+}
+
+VkDescriptorSet VulkanDescriptorAllocator::allocatePersistent(VkDescriptorSetLayout layout) {
+    return allocate(m_persistent, layout);
+}
+
+VulkanDescriptorAllocator::Stats VulkanDescriptorAllocator::getStats() const {
+    Stats stats {};
+    stats.pools = m_poolCount;
+    stats.transientSets = m_frames[m_frame].allocated;
+    stats.persistentSets = m_persistent.allocated;
+    return stats;
+}
+
+VkDescriptorSet VulkanDescriptorAllocator::allocate(Pools& pools, VkDescriptorSetLayout layout) {
+    if (m_fitted.count(layout) == 0) {
+        fitLayout(layout);
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = getPool(pools);
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    VkDescriptorSet set;
+    VkResult result = vkAllocateDescriptorSets(m_device, &allocInfo, &set);
+
+    // exhausted: retire the pool until the next reset and retry once in a fresh, larger one
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+        pools.full.push_back(pools.ready.back());
+        pools.ready.pop_back();
+
+        allocInfo.descriptorPool = getPool(pools);
+        result = vkAllocateDescriptorSets(m_device, &allocInfo, &set);
+    }
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate descriptor set.");
+    }
+
+    pools.allocated++;
+    return set;
+}
+
+void VulkanDescriptorAllocator::fitLayout(VkDescriptorSetLayout layout) {
+    bool grown = false;
+    for (const VkDescriptorPoolSize& size : m_layoutCache.getPoolSizes(layout)) {
+        auto found = std::find_if(m_ratios.begin(), m_ratios.end(),
+            [&size](const PoolSizeRatio& ratio) { return ratio.type == size.type; });
+        if (found == m_ratios.end()) {
+            // a type the ratios don't plan for: room for every set to take as many as this one
+            m_ratios.push_back({size.type, static_cast<float>(size.descriptorCount)});
+            m_minCounts.push_back(size.descriptorCount);
+            grown = true;
+            continue;
+        }
+        uint32_t& minCount = m_minCounts[found - m_ratios.begin()];
+        if (size.descriptorCount > minCount) {
+            minCount = size.descriptorCount;
+            grown = true;
+        }
+    }
+    m_fitted.insert(layout);
+
+    if (!grown) {
+        return;
+    }
+    // sets already allocated stay valid: their pools go once no frame can use them
+    auto retire = [](Pools& pools) {
+        pools.stale.insert(pools.stale.end(), pools.ready.begin(), pools.ready.end());
+        pools.stale.insert(pools.stale.end(), pools.full.begin(), pools.full.end());
+        pools.ready.clear();
+        pools.full.clear();
+    };
+    for (Pools& pools : m_frames) {
+        retire(pools);
+    }
+    retire(m_persistent);
+}
+
+VkDescriptorPool VulkanDescriptorAllocator::getPool(Pools& pools) {
+    if (!pools.ready.empty()) {
+        return pools.ready.back();
+    }
+
+    // each new pool 1.5x the previous: a busy slot settles on a few large pools
+    VkDescriptorPool pool = createPool(pools.setsPerPool);
+    pools.setsPerPool = std::min(pools.setsPerPool + pools.setsPerPool / 2, MAX_SETS_PER_POOL);
+    pools.ready.push_back(pool);
+    return pool;
+}
+
+VkDescriptorPool VulkanDescriptorAllocator::createPool(uint32_t setCount) {
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for (size_t i = 0; i < m_ratios.size(); i++) {
+        uint32_t descriptorCount = std::max(static_cast<uint32_t>(m_ratios[i].ratio * static_cast<float>(setCount)), m_minCounts[i]);
+        poolSizes.push_back({m_ratios[i].type, descriptorCount});
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = 0;     // no vkFreeDescriptorSets: sets go with the pool reset
+    poolInfo.maxSets = setCount;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    VkDescriptorPool pool;
+    if (vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create descriptor pool.");
+    }
+
+    m_poolCount++;
+    return pool;
+}
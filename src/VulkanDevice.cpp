@@ -2,6 +2,7 @@
 
 #include <SDL_vulkan.h>
 
+#include "MLogger.h"
 #include "MWindow.h"
 #include "vk_initializers.h"
 
@@ -17,16 +18,24 @@
 using namespace moo;
 
 // class member functions
-VulkanDevice::VulkanDevice(MWindow &window) : m_window{window} {
+VulkanDevice::VulkanDevice(MWindow &window, bool bindless) : m_window{window}, m_bindless{bindless} {
     createInstance();
     setupDebugMessenger();
     createSurface();
     pickPhysicalDevice();
     createLogicalDevice();
     createCommandPool();
+    createPipelineCache();
+    createShaderCache();
+    createLayoutCache();
+    createPipelineLibrary();
 }
 
 VulkanDevice::~VulkanDevice() {
+    m_pipelineLibrary.reset();
+    m_layoutCache.reset();
+    m_shaderCache.reset();
+    m_pipelineCache.reset(); // saved to disk on destruction
     vkDestroyCommandPool(m_device, m_commandPool, nullptr);
     vkDestroyDevice(m_device, nullptr);
 
@@ -175,6 +184,9 @@ void VulkanDevice::createLogicalDevice() {
 // features
     VkPhysicalDeviceFeatures deviceFeatures {};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    // GPU-driven draws: many draws per indirect call, firstInstance read from the buffer
+    deviceFeatures.multiDrawIndirect = m_deviceFeatures.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance = m_deviceFeatures.drawIndirectFirstInstance;
 
     VkDeviceCreateInfo createInfo {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -183,8 +195,74 @@ void VulkanDevice::createLogicalDevice() {
     createInfo.pEnabledFeatures = &deviceFeatures;
 
 // extension
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(m_deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = m_deviceExtensions.data();
+    m_enabledDeviceExtensions = m_deviceExtensions;
+    for (const char* extension : m_optionalDeviceExtensions) {
+        if (checkDeviceExtensionSupport(m_physicalDevice, {extension})) {
+            m_enabledDeviceExtensions.push_back(extension);
+        }
+    }
+
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(m_enabledDeviceExtensions.size());
+    createInfo.ppEnabledExtensionNames = m_enabledDeviceExtensions.data();
+
+    // draw count read from a buffer (vkCmdDrawIndexedIndirectCount), core in 1.2
+    VkPhysicalDeviceVulkan12Features vulkan12Features {};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    if (m_deviceProperties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceVulkan12Features supported12Features {};
+        supported12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 features2 {};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &supported12Features;
+        vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features2);
+
+        vulkan12Features.drawIndirectCount = supported12Features.drawIndirectCount;
+        m_drawIndirectCount = supported12Features.drawIndirectCount == VK_TRUE;
+        // update-after-bind arrays, bindless materials: only when asked for
+        if (m_bindless) {
+            m_bindlessCapacity = VulkanBindlessTable::enableFeatures(m_physicalDevice, vulkan12Features);
+        }
+
+        vulkan12Features.pNext = const_cast<void*>(createInfo.pNext);
+        createInfo.pNext = &vulkan12Features;
+    }
+
+#ifdef VK_KHR_maintenance5
+    // inline shader module creation (VkShaderModuleCreateInfo chained to the stage)
+    VkPhysicalDeviceMaintenance5FeaturesKHR maintenance5Features {};
+    maintenance5Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MAINTENANCE_5_FEATURES_KHR;
+    maintenance5Features.maintenance5 = VK_TRUE;
+    if (isExtensionEnabled(VK_KHR_MAINTENANCE_5_EXTENSION_NAME)) {
+        maintenance5Features.pNext = const_cast<void*>(createInfo.pNext);
+        createInfo.pNext = &maintenance5Features;
+    }
+#endif
+
+#ifdef VK_EXT_graphics_pipeline_library
+    // pipeline parts compiled once and linked per variant, see VulkanPipelineLibrary
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipelineLibraryFeatures {};
+    pipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+    if (isExtensionEnabled(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+        VkPhysicalDeviceFeatures2 features2 {};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &pipelineLibraryFeatures;
+        vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features2);
+
+        VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT pipelineLibraryProperties {};
+        pipelineLibraryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2 properties2 {};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &pipelineLibraryProperties;
+        vkGetPhysicalDeviceProperties2(m_physicalDevice, &properties2);
+
+        if (pipelineLibraryFeatures.graphicsPipelineLibrary) {
+            pipelineLibraryFeatures.pNext = const_cast<void*>(createInfo.pNext);
+            createInfo.pNext = &pipelineLibraryFeatures;
+        }
+        // without fast linking a link costs about as much as a full compile
+        m_graphicsPipelineLibrary = pipelineLibraryFeatures.graphicsPipelineLibrary && pipelineLibraryProperties.graphicsPipelineLibraryFastLinking;
+    }
+#endif
 
 // layers
     // enabledLayerCount and ppEnabledLayerNames fields of VkDeviceCreateInfo are ignored by up-to-date implementations. 
@@ -221,6 +299,36 @@ void VulkanDevice::createCommandPool() {
     }
 }
 
+void VulkanDevice::createShaderCache() {
+    bool inlineModules = false;
+#ifdef VK_KHR_maintenance5
+    inlineModules = isExtensionEnabled(VK_KHR_MAINTENANCE_5_EXTENSION_NAME);
+#endif
+    m_shaderCache = std::make_unique<VulkanShaderCache>(m_device, inlineModules);
+}
+
+bool VulkanDevice::isExtensionEnabled(const char* extensionName) const {
+    for (const char* extension : m_enabledDeviceExtensions) {
+        if (strcmp(extension, extensionName) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void VulkanDevice::createLayoutCache() {
+    m_layoutCache = std::make_unique<VulkanLayoutCache>(m_device);
+}
+
+void VulkanDevice::createPipelineLibrary() {
+    m_pipelineLibrary = std::make_unique<VulkanPipelineLibrary>(m_device, m_pipelineCache->getCache(), m_graphicsPipelineLibrary);
+    MOO_LOG_INFO("Graphics pipeline library: %s", m_graphicsPipelineLibrary ? "enabled" : "unavailable, monolithic pipelines");
+}
+
+void VulkanDevice::createPipelineCache() {
+    m_pipelineCache = std::make_unique<VulkanPipelineCache>(m_device, m_deviceProperties, PIPELINE_CACHE_FILE);
+}
+
 bool VulkanDevice::checkValidationLayerSupport(std::vector<const char*> validationLayers) {
 	uint32_t layerCount;
 	vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
@@ -322,7 +430,8 @@ QueueFamilyIndices VulkanDevice::findQueueFamilies(VkPhysicalDevice device) {
 
     int i = 0;
     for (const auto &queueFamily : queueFamilies) {
-        if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        // compute dispatches are recorded with the draws, in the same command buffers
+        if ((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
             indices.graphicsFamily = i;
         }
 
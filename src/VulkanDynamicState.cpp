@@ -0,0 +1,87 @@
+#include "VulkanDynamicState.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace moo;
+
+bool VulkanDynamicState::isSupported(const VkPhysicalDeviceProperties& properties) {
+    return properties.apiVersion >= VK_API_VERSION_1_3;
+}
+
+void VulkanDynamicState::addDynamicStates(std::vector<VkDynamicState>& dynamicStates) {
+    for (VkDynamicState state : DYNAMIC_STATES) {
+        if (std::find(dynamicStates.begin(), dynamicStates.end(), state) == dynamicStates.end()) {
+            dynamicStates.push_back(state);
+        }
+    }
+}
+
+void VulkanDynamicState::begin(VkCommandBuffer commandBuffer) {
+    m_commandBuffer = commandBuffer;
+    m_known = 0;
+}
+
+void VulkanDynamicState::invalidate() {
+    m_known = 0;
+}
+
+void VulkanDynamicState::apply(const State& state) {
+    setCullMode(state.cullMode);
+    setFrontFace(state.frontFace);
+    setPrimitiveTopology(state.topology);
+    setDepthTestEnable(state.depthTestEnable);
+    setDepthWriteEnable(state.depthWriteEnable);
+    setDepthCompareOp(state.depthCompareOp);
+}
+
+void VulkanDynamicState::setCullMode(VkCullModeFlags cullMode) {
+    if (update(CullMode, m_state.cullMode, cullMode)) {
+        vkCmdSetCullMode(m_commandBuffer, cullMode);
+    }
+}
+
+void VulkanDynamicState::setFrontFace(VkFrontFace frontFace) {
+    if (update(FrontFace, m_state.frontFace, frontFace)) {
+        vkCmdSetFrontFace(m_commandBuffer, frontFace);
+    }
+}
+
+void VulkanDynamicState::setPrimitiveTopology(VkPrimitiveTopology topology) {
+    if (update(Topology, m_state.topology, topology)) {
+        vkCmdSetPrimitiveTopology(m_commandBuffer, topology);
+    }
+}
+
+void VulkanDynamicState::setDepthTestEnable(VkBool32 enable) {
+    if (update(DepthTest, m_state.depthTestEnable, enable)) {
+        vkCmdSetDepthTestEnable(m_commandBuffer, enable);
+    }
+}
+
+void VulkanDynamicState::setDepthWriteEnable(VkBool32 enable) {
+    if (update(DepthWrite, m_state.depthWriteEnable, enable)) {
+        vkCmdSetDepthWriteEnable(m_commandBuffer, enable);
+    }
+}
+
+void VulkanDynamicState::setDepthCompareOp(VkCompareOp compareOp) {
+    if (update(DepthCompare, m_state.depthCompareOp, compareOp)) {
+        vkCmdSetDepthCompareOp(m_commandBuffer, compareOp);
+    }
+}
+
+template <typename T>
+bool VulkanDynamicState::update(Bit bit, T& current, T value) {
+    assert(m_commandBuffer != VK_NULL_HANDLE && "Cannot set dynamic state before begin().");
+
+    if ((m_known & bit) && current == value) {
+        m_skipped++;
+        return false;
+    }
+
+    current = value;
+    m_known |= bit;
+    m_recorded++;
+    return true;
+}
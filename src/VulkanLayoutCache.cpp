@@ -0,0 +1,194 @@
+#include "VulkanLayoutCache.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace moo;
+
+// FNV-1a over the fields, as the pipeline registry keys
+void VulkanLayoutCache::Key::add(uint64_t value) {
+    fields.push_back(value);
+    for (int i = 0; i < 8; i++) {
+        hash ^= (value >> (i * 8)) & 0xff;
+        hash *= 1099511628211ULL;
+    }
+}
+
+VulkanLayoutCache::VulkanLayoutCache(VkDevice device) : m_device{device} {}
+
+VulkanLayoutCache::~VulkanLayoutCache() {
+    for (auto& [key, layout] : m_pipelineLayouts) {
+        vkDestroyPipelineLayout(m_device, layout, nullptr);
+    }
+    for (auto& [key, layout] : m_setLayouts) {
+        vkDestroyDescriptorSetLayout(m_device, layout, nullptr);
+    }
+}
+
+VulkanLayoutCache::Layout VulkanLayoutCache::getLayout(std::initializer_list<const VulkanShaderReflection*> stages, const VkPushConstantRange& declared) {
+    // set -> bindings, a binding seen by several stages is one binding with their stage flags
+    std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets;
+    VkPushConstantRange pushConstants {};
+    uint32_t pushConstantsEnd = 0;
+
+    for (const VulkanShaderReflection* stage : stages) {
+        for (const VulkanShaderReflection::DescriptorBinding& binding : stage->getBindings()) {
+            if (binding.set >= sets.size()) {
+                sets.resize(binding.set + 1);
+            }
+            std::vector<VkDescriptorSetLayoutBinding>& set = sets[binding.set];
+            auto found = std::find_if(set.begin(), set.end(),
+                [&binding](const VkDescriptorSetLayoutBinding& b) { return b.binding == binding.binding; });
+            if (found == set.end()) {
+                VkDescriptorSetLayoutBinding setBinding {};
+                setBinding.binding = binding.binding;
+                setBinding.descriptorType = binding.type;
+                setBinding.descriptorCount = binding.count;
+                setBinding.stageFlags = binding.stages;
+                set.push_back(setBinding);
+            } else if (found->descriptorType != binding.type || found->descriptorCount != binding.count) {
+                throw std::runtime_error("Failed to create pipeline layout: stages disagree on a descriptor binding.");
+            } else {
+                found->stageFlags |= binding.stages;
+            }
+        }
+
+        const VkPushConstantRange& range = stage->getPushConstantRange();
+        if (range.size > 0) {
+            if (pushConstants.stageFlags == 0) {
+                pushConstants.offset = range.offset;
+            }
+            pushConstants.stageFlags |= range.stageFlags;
+            pushConstants.offset = std::min(pushConstants.offset, range.offset);
+            pushConstantsEnd = std::max(pushConstantsEnd, range.offset + range.size);
+        }
+    }
+    if (pushConstants.stageFlags != 0) {
+        pushConstants.size = pushConstantsEnd - pushConstants.offset;
+    }
+
+    // declared by the application: may be larger than what the shaders read, never smaller
+    if (declared.size > 0) {
+        bool covered = pushConstants.size == 0 || (
+            (pushConstants.stageFlags & ~declared.stageFlags) == 0 &&
+            pushConstants.offset >= declared.offset &&
+            pushConstants.offset + pushConstants.size <= declared.offset + declared.size);
+        if (!covered) {
+            throw std::runtime_error("Failed to create pipeline layout: push constant block doesn't cover the shaders' one.");
+        }
+        pushConstants = declared;
+    }
+
+    Layout layout {};
+    for (std::vector<VkDescriptorSetLayoutBinding>& set : sets) {
+        layout.setLayouts.push_back(getSetLayout(std::move(set)));
+    }
+    layout.pushConstants = pushConstants;
+    layout.pipelineLayout = getPipelineLayout(layout.setLayouts, pushConstants);
+    return layout;
+}
+
+VkDescriptorSetLayout VulkanLayoutCache::getSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings) {
+    // binding order doesn't change the layout, nor the key
+    std::sort(bindings.begin(), bindings.end(),
+        [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+
+    Key key;
+    for (const VkDescriptorSetLayoutBinding& binding : bindings) {
+        if (binding.descriptorCount == 0) {
+            throw std::runtime_error("Failed to create descriptor set layout: runtime descriptor arrays are not supported.");
+        }
+        key.add(binding.binding);
+        key.add(binding.descriptorType);
+        key.add(binding.descriptorCount);
+        key.add(binding.stageFlags);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_setLayouts.find(key);
+    if (found != m_setLayouts.end()) {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return found->second;
+    }
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo {};
+    setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    setLayoutInfo.pBindings = bindings.data();
+
+    VkDescriptorSetLayout setLayout;
+    if (vkCreateDescriptorSetLayout(m_device, &setLayoutInfo, nullptr, &setLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create descriptor set layout.");
+    }
+
+    std::vector<VkDescriptorPoolSize>& poolSizes = m_poolSizes[setLayout];
+    for (const VkDescriptorSetLayoutBinding& binding : bindings) {
+        auto found = std::find_if(poolSizes.begin(), poolSizes.end(),
+            [&binding](const VkDescriptorPoolSize& size) { return size.type == binding.descriptorType; });
+        if (found == poolSizes.end()) {
+            poolSizes.push_back({binding.descriptorType, binding.descriptorCount});
+        } else {
+            found->descriptorCount += binding.descriptorCount;
+        }
+    }
+
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    m_setLayouts.emplace(std::move(key), setLayout);
+    return setLayout;
+}
+
+VkPipelineLayout VulkanLayoutCache::getPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const VkPushConstantRange& pushConstants) {
+    // set layouts come from this cache: equal handles, equal layouts
+    Key key;
+    for (VkDescriptorSetLayout setLayout : setLayouts) {
+        key.add(reinterpret_cast<uint64_t>(setLayout));
+    }
+    key.add(pushConstants.stageFlags);
+    key.add(pushConstants.offset);
+    key.add(pushConstants.size);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_pipelineLayouts.find(key);
+    if (found != m_pipelineLayouts.end()) {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return found->second;
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+    if (pushConstants.size > 0) {
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstants;
+    }
+
+    VkPipelineLayout pipelineLayout;
+    if (vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline layout.");
+    }
+
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    m_pipelineLayouts.emplace(std::move(key), pipelineLayout);
+    return pipelineLayout;
+}
+
+std::vector<VkDescriptorPoolSize> VulkanLayoutCache::getPoolSizes(VkDescriptorSetLayout setLayout) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_poolSizes.find(setLayout);
+    if (found == m_poolSizes.end()) {
+        return {};
+    }
+    return found->second;
+}
+
+VulkanLayoutCache::Stats VulkanLayoutCache::getStats() {
+    Stats stats {};
+    stats.hits = m_hits.load(std::memory_order_relaxed);
+    stats.misses = m_misses.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats.setLayouts = static_cast<uint32_t>(m_setLayouts.size());
+    stats.pipelineLayouts = static_cast<uint32_t>(m_pipelineLayouts.size());
+    return stats;
+}
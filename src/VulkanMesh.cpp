@@ -1,5 +1,7 @@
 #include "VulkanMesh.h"
 
+#include <algorithm>
+
 using namespace mii;
 
 VertexInputDescription Vertex::getVertexInputDescription() {
@@ -37,6 +39,31 @@ void Mesh::bind(VkCommandBuffer cmd) {
     vkCmdBindIndexBuffer(cmd, vertexIndexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
 }
 
+void Mesh::bind(moo::VulkanCommandEncoder& encoder) {
+    VkDeviceSize offset = indices_size;
+    encoder.bindVertexBuffers(0, 1, &vertexIndexBuffer.buffer, &offset);
+    encoder.bindIndexBuffer(vertexIndexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+}
+
 void Mesh::draw(VkCommandBuffer cmd) {
-    vkCmdDrawIndexed(cmd, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+    draw(cmd, 1, 0);
+}
+
+void Mesh::draw(VkCommandBuffer cmd, uint32_t instanceCount, uint32_t firstInstance, uint32_t lod) {
+    if (instanceCount == 0) {
+        return;
+    }
+    if (lods.empty()) {
+        vkCmdDrawIndexed(cmd, static_cast<uint32_t>(indices.size()), instanceCount, 0, 0, firstInstance);
+        return;
+    }
+    const moo::MMeshSimplifier::Lod& range = lods[std::min(lod, static_cast<uint32_t>(lods.size() - 1))];
+    vkCmdDrawIndexed(cmd, range.indexCount, instanceCount, range.firstIndex, 0, firstInstance);
+}
+
+void Mesh::generateLods(uint32_t maxLods) {
+    if (indices.empty() || !lods.empty()) {
+        return;
+    }
+    lods = moo::MMeshSimplifier::buildLodChain(&vertices[0].position.x, &vertices[0].color.x, 3, vertices.size(), sizeof(Vertex), indices, maxLods);
 }
\ No newline at end of file
@@ -1,12 +1,21 @@
 #include "VulkanModel.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
 using namespace moo;
 
-VulkanModel::VulkanModel(VulkanDevice &device, const Builder &builder) : m_device{device} {
+VulkanModel::VulkanModel(VulkanDevice &device, const Builder &builder) : m_device{device}, m_boundingSphere{builder.getBoundingSphere()} {
     createVertexBuffer(builder.vertices);
     createIndexBuffer(builder.indices);
+
+    m_lods = builder.lods;
+    if (m_lods.empty()) {
+        MMeshSimplifier::Lod lod {};
+        lod.indexCount = m_indexCount;
+        m_lods.push_back(lod);
+    }
 }
 
 VulkanModel::~VulkanModel() {
@@ -101,12 +110,30 @@ void VulkanModel::bind(VkCommandBuffer cmd) {
     }
 }
 
+void VulkanModel::bind(VulkanCommandEncoder& encoder) {
+    VkDeviceSize offset = 0;
+    encoder.bindVertexBuffers(0, 1, &m_vertexBuffer.buffer, &offset);
+
+    if(m_hasIndexBuffer) {
+        encoder.bindIndexBuffer(m_indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+    }
+}
+
 void VulkanModel::draw(VkCommandBuffer cmd) {
+    draw(cmd, 1, 0);
+}
+
+void VulkanModel::draw(VkCommandBuffer cmd, uint32_t instanceCount, uint32_t firstInstance, uint32_t lod) {
+    if (instanceCount == 0) {
+        return;
+    }
+
     if (m_hasIndexBuffer) {
-        vkCmdDrawIndexed(cmd, m_indexCount, 1, 0, 0, 0);
+        const MMeshSimplifier::Lod& range = m_lods[std::min(lod, static_cast<uint32_t>(m_lods.size() - 1))];
+        vkCmdDrawIndexed(cmd, range.indexCount, instanceCount, range.firstIndex, 0, firstInstance);
     } else {
-        vkCmdDraw(cmd, m_vertexCount, 1, 0, 0);
-    }    
+        vkCmdDraw(cmd, m_vertexCount, instanceCount, 0, firstInstance);
+    }
 }
 
 std::vector<VkVertexInputBindingDescription> VulkanModel::Vertex::getBindingDescriptions() {
@@ -133,4 +160,33 @@ std::vector<VkVertexInputAttributeDescription> VulkanModel::Vertex::getAttribute
     attribute_desc[1].offset = offsetof(VulkanModel::Vertex, color);
 
     return attribute_desc;
-}
\ No newline at end of file
+}
+
+glm::vec4 VulkanModel::Builder::getBoundingSphere() const {
+    if (vertices.empty()) {
+        return glm::vec4{0.0f};
+    }
+
+    // center of the bounding box, not the tightest sphere but close enough to cull with
+    glm::vec3 minimum = vertices[0].position;
+    glm::vec3 maximum = vertices[0].position;
+    for (const Vertex& vertex : vertices) {
+        minimum = glm::vec3{std::min(minimum.x, vertex.position.x), std::min(minimum.y, vertex.position.y), std::min(minimum.z, vertex.position.z)};
+        maximum = glm::vec3{std::max(maximum.x, vertex.position.x), std::max(maximum.y, vertex.position.y), std::max(maximum.z, vertex.position.z)};
+    }
+    glm::vec3 center = (minimum + maximum) * 0.5f;
+
+    float radius = 0.0f;
+    for (const Vertex& vertex : vertices) {
+        glm::vec3 d = vertex.position - center;
+        radius = std::max(radius, d.x * d.x + d.y * d.y + d.z * d.z);
+    }
+    return glm::vec4{center, std::sqrt(radius)};
+}
+
+void VulkanModel::Builder::generateLods(uint32_t maxLods) {
+    if (indices.empty() || !lods.empty()) {
+        return;
+    }
+    lods = MMeshSimplifier::buildLodChain(&vertices[0].position.x, &vertices[0].color.x, 3, vertices.size(), sizeof(Vertex), indices, maxLods);
+}
@@ -3,61 +3,67 @@
 #include "vk_initializers.h"
 #include "VulkanModel.h"
 
-#include <fstream>
 #include <array>
+#include <stdexcept>
 #include <cassert>
 
 using namespace moo;
 
 VulkanPipeline::VulkanPipeline(VulkanDevice& device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo) : m_device{device} {
-    createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
+    m_graphicsPipeline = createGraphicsPipeline(device, vertFilepath, fragFilepath, configInfo);
 }
 
-VulkanPipeline::~VulkanPipeline() {
-    vkDestroyShaderModule(m_device.getDevice(), m_vertShaderModule, nullptr);
-    vkDestroyShaderModule(m_device.getDevice(), m_fragShaderModule, nullptr);
-    vkDestroyPipeline(m_device.getDevice(), m_graphicsPipeline, nullptr);
+VulkanPipeline::VulkanPipeline(VulkanDevice& device, VkPipeline pipeline, VulkanPipelineRegistry* registry) :
+    m_device{device}, m_registry{registry}, m_graphicsPipeline{pipeline} 
+{
+    assert(pipeline != VK_NULL_HANDLE && "Cannot adopt a null pipeline.");
 }
 
-std::vector<char> VulkanPipeline::readFile(const std::string& filepath) {
-    // open file, cursor at the end
-    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
-
-    if(!file.is_open())
-        throw std::runtime_error("Failed to open file: " + filepath);
-
-    std::streampos filesize = file.tellg();
-    // spirv expects the buffer to be an uint32 instead of a char,
-    // reserve an int vector big enough for the entire file ELEMENTS
-    // std::vector<uint32_t> buffer(filesize / sizeof(uint32_t)); // bytes -> uint32
-    // std::vector<char> buffer(fileSize); equals to 
-    std::vector<char> buffer(filesize / sizeof(char));
-
-    file.seekg(0, std::ios::beg); // file cursor at the beginning, rdy to read 
-    file.read(buffer.data(), filesize);
+VulkanPipeline::VulkanPipeline(VulkanDevice& device, VulkanPipelineRegistry& registry, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo) :
+    m_device{device}, m_registry{&registry}
+{
+    m_graphicsPipeline = createGraphicsPipeline(device, vertFilepath, fragFilepath, configInfo, m_registry);
+}
 
-    file.close();
-    return buffer;
+VulkanPipeline::~VulkanPipeline() {
+    // shader modules belong to the device shader cache, reused by the next rebuild
+    if (m_registry) {
+        m_registry->release(m_graphicsPipeline);
+    } else {
+        vkDestroyPipeline(m_device.getDevice(), m_graphicsPipeline, nullptr);
+    }
 }
 
-void VulkanPipeline::createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo) {
+VkPipeline VulkanPipeline::createGraphicsPipeline(VulkanDevice& device, const std::string& vertFilepath, const std::string& fragFilepath,
+    const PipelineConfigInfo& configInfo, VulkanPipelineRegistry* registry, VulkanPipelineLibrary::Link link, VkRenderPass renderpass)
+{
+    if (renderpass == VK_NULL_HANDLE) {
+        renderpass = configInfo.renderpass;
+    }
     assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline: no pipelineLayout provided to configInfo.");
-    assert(configInfo.renderpass != VK_NULL_HANDLE && "Cannot create graphics pipeline: no renderpass provided to configInfo.");
+    assert(renderpass != VK_NULL_HANDLE && "Cannot create graphics pipeline: no renderpass provided to configInfo.");
     
-    std::vector<char> vertCode = readFile(vertFilepath);
-    std::vector<char> fragCode = readFile(fragFilepath);
-
-    createShaderModule(vertCode, &m_vertShaderModule, vertFilepath);
-    createShaderModule(fragCode, &m_fragShaderModule, fragFilepath);
-
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo = vkinit::pipelineShaderStageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT, m_vertShaderModule);
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo = vkinit::pipelineShaderStageCreateInfo(VK_SHADER_STAGE_FRAGMENT_BIT, m_fragShaderModule);
+    // mapped and compiled once, a rebuild after a resize is a lookup
+    VulkanShaderCache& shaders = device.getShaderCache();
+    VkPipelineShaderStageCreateInfo vertShaderStageInfo = shaders.getStageInfo(vertFilepath, VK_SHADER_STAGE_VERTEX_BIT);
+    VkPipelineShaderStageCreateInfo fragShaderStageInfo = shaders.getStageInfo(fragFilepath, VK_SHADER_STAGE_FRAGMENT_BIT);
+
+    VkSpecializationInfo vertSpecializationInfo = configInfo.vertSpecialization.getInfo();
+    VkSpecializationInfo fragSpecializationInfo = configInfo.fragSpecialization.getInfo();
+    if (!configInfo.vertSpecialization.empty()) {
+        vertShaderStageInfo.pSpecializationInfo = &vertSpecializationInfo;
+    }
+    if (!configInfo.fragSpecialization.empty()) {
+        fragShaderStageInfo.pSpecializationInfo = &fragSpecializationInfo;
+    }
 
     std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages = {vertShaderStageInfo, fragShaderStageInfo};
 
     // vertex input
     auto binding_descriptions = VulkanModel::Vertex::getBindingDescriptions();
     auto attributes_descriptions = VulkanModel::Vertex::getAttributeDescriptions();
+    assert(shaders.getReflection(vertFilepath).matchesVertexAttributes(attributes_descriptions) &&
+        "Cannot create graphics pipeline: VulkanModel::Vertex doesn't match the vertex shader inputs.");
     VkPipelineVertexInputStateCreateInfo vertexInputInfo = vkinit::pipelineVertexInputCreateInfo();
     vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(binding_descriptions.size());
     vertexInputInfo.pVertexBindingDescriptions = binding_descriptions.data();
@@ -95,27 +101,38 @@ void VulkanPipeline::createGraphicsPipeline(const std::string& vertFilepath, con
 // Pipeline layout: the uniform and push values referenced by the shader that can be updated at draw time
     pipelineInfo.layout = configInfo.pipelineLayout;
 // Render pass: the attachments referenced by the pipeline stages and their usage
-    pipelineInfo.renderPass = configInfo.renderpass;
+    pipelineInfo.renderPass = renderpass;
     pipelineInfo.subpass = configInfo.subpass;
 
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
     pipelineInfo.basePipelineIndex = -1; // Optional
 
-    if(vkCreateGraphicsPipelines(m_device.getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to create graphics pipeline."); // failed to create graphics pipeline
+    VulkanPipelineRegistry::AttachmentFormats formats {};
+    formats.color = configInfo.colorAttachmentFormats;
+    formats.depth = configInfo.depthAttachmentFormat;
+    formats.samples = configInfo.multisampleInfo.rasterizationSamples;
+    const VulkanPipelineRegistry::AttachmentFormats* attachmentFormats = formats.color.empty() ? nullptr : &formats;
+
+    VulkanPipelineLibrary* library = nullptr;
+    if (link != VulkanPipelineLibrary::Link::Monolithic && device.getPipelineLibrary().isSupported()) {
+        library = &device.getPipelineLibrary();
     }
-}
+    bool optimize = link == VulkanPipelineLibrary::Link::Optimized;
 
-void VulkanPipeline::createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule, const std::string& filepath) {
-    VkShaderModuleCreateInfo info {};
-    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    info.codeSize = code.size();
-    info.pCode = reinterpret_cast<const uint32_t*>(code.data());
+    if (registry) {
+        return registry->acquire(pipelineInfo, attachmentFormats, library, optimize);
+    }
+    if (library) {
+        return library->link(pipelineInfo, attachmentFormats, optimize);
+    }
 
-    // check creation went well, 
-    // cause there are often error VK_CHECK isn't suitable
-    if(vkCreateShaderModule(m_device.getDevice(), &info, nullptr, shaderModule) != VK_SUCCESS)
-        throw std::runtime_error("Failed to create shader module: " + filepath);
+    // the pipeline cache is internally synchronized, workers can share it
+    VkPipeline pipeline;
+    if(vkCreateGraphicsPipelines(device.getDevice(), device.getPipelineCache().getCache(), 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create graphics pipeline."); // failed to create graphics pipeline
+    }
+
+    return pipeline;
 }
 
 void VulkanPipeline::defaultPipelineConfigInfo(PipelineConfigInfo &configInfo) {
@@ -141,7 +158,19 @@ void VulkanPipeline::defaultPipelineConfigInfo(PipelineConfigInfo &configInfo) {
     configInfo.dynamicStateInfo.flags = 0;
 }
 
+void VulkanPipeline::enableExtendedDynamicState(PipelineConfigInfo &configInfo) {
+    VulkanDynamicState::addDynamicStates(configInfo.dynamicStateEnables);
+
+    configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
+    configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
+}
+
 void VulkanPipeline::bind(VkCommandBuffer commandBuffer) {
     assert(m_graphicsPipeline != nullptr);
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline);
+}
+
+void VulkanPipeline::bind(VulkanCommandEncoder& encoder) {
+    assert(m_graphicsPipeline != nullptr);
+    encoder.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline);
 }
\ No newline at end of file
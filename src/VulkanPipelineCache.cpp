@@ -0,0 +1,166 @@
+#include "VulkanPipelineCache.h"
+
+#include "MLogger.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+using namespace moo;
+
+VulkanPipelineCache::VulkanPipelineCache(VkDevice device, const VkPhysicalDeviceProperties& properties, std::string filepath) :
+    m_device{device}, m_properties{properties}, m_filepath{std::move(filepath)}
+{
+    std::vector<char> initialData = load();
+
+    VkPipelineCacheCreateInfo cacheInfo {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = initialData.size();
+    cacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+    if (vkCreatePipelineCache(m_device, &cacheInfo, nullptr, &m_cache) != VK_SUCCESS) {
+        // the driver can still refuse data that passed our checks, start cold rather than fail
+        MOO_LOG_WARNING("pipeline cache %s rejected by the driver, starting empty", m_filepath.c_str());
+
+        cacheInfo.initialDataSize = 0;
+        cacheInfo.pInitialData = nullptr;
+        if (vkCreatePipelineCache(m_device, &cacheInfo, nullptr, &m_cache) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline cache.");
+        }
+    } else if (!initialData.empty()) {
+        m_savedSize = initialData.size();
+        MOO_LOG_INFO("pipeline cache loaded: %zu bytes", initialData.size());
+    }
+
+    m_lastSave = std::chrono::steady_clock::now();
+}
+
+VulkanPipelineCache::~VulkanPipelineCache() {
+    save();
+    vkDestroyPipelineCache(m_device, m_cache, nullptr);
+}
+
+std::vector<char> VulkanPipelineCache::load() {
+    std::ifstream file(m_filepath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return {}; // first run
+    }
+
+    std::streamoff filesize = file.tellg();
+    FileHeader header {};
+    if (filesize < static_cast<std::streamoff>(sizeof(FileHeader))) {
+        MOO_LOG_WARNING("pipeline cache %s truncated, ignored", m_filepath.c_str());
+        return {};
+    }
+
+    file.seekg(0, std::ios::beg);
+    file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+
+    bool sameDevice = header.magic == FILE_MAGIC && header.version == FILE_VERSION &&
+        header.vendorID == m_properties.vendorID &&
+        header.deviceID == m_properties.deviceID &&
+        header.driverVersion == m_properties.driverVersion &&
+        std::memcmp(header.pipelineCacheUUID, m_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+
+    if (!sameDevice) {
+        MOO_LOG_INFO("pipeline cache %s written by another device or driver, ignored", m_filepath.c_str());
+        return {};
+    }
+
+    if (header.dataSize != static_cast<uint64_t>(filesize) - sizeof(FileHeader)) {
+        MOO_LOG_WARNING("pipeline cache %s size mismatch, ignored", m_filepath.c_str());
+        return {};
+    }
+
+    std::vector<char> data(static_cast<size_t>(header.dataSize));
+    file.read(data.data(), static_cast<std::streamsize>(data.size()));
+
+    if (!file || checksum(data.data(), data.size()) != header.checksum) {
+        MOO_LOG_WARNING("pipeline cache %s corrupted, ignored", m_filepath.c_str());
+        return {};
+    }
+
+    return data;
+}
+
+bool VulkanPipelineCache::save() {
+    m_lastSave = std::chrono::steady_clock::now();
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(m_device, m_cache, &size, nullptr) != VK_SUCCESS || size == 0) {
+        return false;
+    }
+
+    // the driver appends new pipelines: an unchanged size means nothing worth writing
+    if (size == m_savedSize) {
+        return true;
+    }
+
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(m_device, m_cache, &size, data.data()) != VK_SUCCESS) {
+        return false;
+    }
+    data.resize(size);
+
+    FileHeader header = makeHeader(data);
+    std::string tmpFilepath = m_filepath + ".tmp";
+    {
+        std::ofstream file(tmpFilepath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            MOO_LOG_WARNING("failed to write pipeline cache %s", tmpFilepath.c_str());
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        file.flush();
+
+        if (!file) {
+            MOO_LOG_WARNING("failed to write pipeline cache %s", tmpFilepath.c_str());
+            return false;
+        }
+    }
+
+    // replaces the previous file in one step, readers see the old or the new cache
+    std::error_code error;
+    std::filesystem::rename(tmpFilepath, m_filepath, error);
+    if (error) {
+        MOO_LOG_WARNING("failed to replace pipeline cache %s: %s", m_filepath.c_str(), error.message().c_str());
+        std::filesystem::remove(tmpFilepath, error);
+        return false;
+    }
+
+    m_savedSize = data.size();
+    MOO_LOG_DEBUG("pipeline cache saved: %zu bytes", data.size());
+    return true;
+}
+
+void VulkanPipelineCache::saveIfDue() {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_lastSave;
+    if (elapsed.count() >= m_saveInterval) {
+        save();
+    }
+}
+
+VulkanPipelineCache::FileHeader VulkanPipelineCache::makeHeader(const std::vector<char>& data) const {
+    FileHeader header {};
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    header.vendorID = m_properties.vendorID;
+    header.deviceID = m_properties.deviceID;
+    header.driverVersion = m_properties.driverVersion;
+    std::memcpy(header.pipelineCacheUUID, m_properties.pipelineCacheUUID, VK_UUID_SIZE);
+    header.dataSize = data.size();
+    header.checksum = checksum(data.data(), data.size());
+    return header;
+}
+
+uint64_t VulkanPipelineCache::checksum(const char* data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
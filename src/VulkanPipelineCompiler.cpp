@@ -0,0 +1,27 @@
+#include "VulkanPipelineCompiler.h"
+
+#include <cassert>
+
+using namespace moo;
+
+VulkanPipelineCompiler::VulkanPipelineCompiler(VulkanDevice& device, uint32_t threadCount) : m_device{device}, m_pool{threadCount} {}
+
+std::future<VkPipeline> VulkanPipelineCompiler::compile(Request request) {
+    assert(request.config != nullptr && "Cannot compile a pipeline without configInfo.");
+
+    return m_pool.submit([this, request = std::move(request)]() {
+        return VulkanPipeline::createGraphicsPipeline(m_device, request.vertFilepath, request.fragFilepath, *request.config, request.registry, request.link,
+            request.renderpass);
+    });
+}
+
+std::vector<std::future<VkPipeline>> VulkanPipelineCompiler::compile(std::vector<Request> batch) {
+    std::vector<std::future<VkPipeline>> pipelines;
+    pipelines.reserve(batch.size());
+
+    for (Request& request : batch) {
+        pipelines.push_back(compile(std::move(request)));
+    }
+
+    return pipelines;
+}
@@ -0,0 +1,168 @@
+#include "VulkanPipelineLibrary.h"
+
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+using namespace moo;
+
+VulkanPipelineLibrary::VulkanPipelineLibrary(VkDevice device, VkPipelineCache cache, bool supported) :
+    m_device{device}, m_cache{cache}, m_supported{supported} {}
+
+VulkanPipelineLibrary::~VulkanPipelineLibrary() {
+    for (auto& [key, part] : m_parts) {
+        vkDestroyPipeline(m_device, part, nullptr);
+    }
+}
+
+VkPipeline VulkanPipelineLibrary::link(const VkGraphicsPipelineCreateInfo& pipelineInfo, const VulkanPipelineRegistry::AttachmentFormats* formats,
+    bool optimize)
+{
+    if (!m_supported) {
+        throw std::runtime_error("Failed to link graphics pipeline: graphics pipeline library not supported.");
+    }
+
+#ifdef VK_EXT_graphics_pipeline_library
+    std::array<VkPipeline, PartCount> parts {};
+    for (uint32_t part = 0; part < PartCount; part++) {
+        parts[part] = getPart(static_cast<Part>(part), pipelineInfo, formats);
+    }
+
+    VkPipelineLibraryCreateInfoKHR libraryInfo {};
+    libraryInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+    libraryInfo.libraryCount = static_cast<uint32_t>(parts.size());
+    libraryInfo.pLibraries = parts.data();
+
+    // everything else comes from the parts, the layout has to match theirs
+    VkGraphicsPipelineCreateInfo linkInfo {};
+    linkInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    linkInfo.pNext = &libraryInfo;
+    linkInfo.flags = optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+    linkInfo.layout = pipelineInfo.layout;
+    linkInfo.basePipelineIndex = -1;
+
+    VkPipeline pipeline;
+    if (vkCreateGraphicsPipelines(m_device, m_cache, 1, &linkInfo, nullptr, &pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to link graphics pipeline.");
+    }
+
+    m_links.fetch_add(1, std::memory_order_relaxed);
+    return pipeline;
+#else
+    (void)pipelineInfo;
+    (void)formats;
+    (void)optimize;
+    throw std::runtime_error("Failed to link graphics pipeline: built without VK_EXT_graphics_pipeline_library.");
+#endif
+}
+
+VulkanPipelineLibrary::Stats VulkanPipelineLibrary::getStats() {
+    Stats stats {};
+    stats.partHits = m_partHits.load(std::memory_order_relaxed);
+    stats.partMisses = m_partMisses.load(std::memory_order_relaxed);
+    stats.links = m_links.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats.parts = static_cast<uint32_t>(m_parts.size());
+    return stats;
+}
+
+VkPipeline VulkanPipelineLibrary::getPart(Part part, const VkGraphicsPipelineCreateInfo& pipelineInfo, const VulkanPipelineRegistry::AttachmentFormats* formats) {
+#ifdef VK_EXT_graphics_pipeline_library
+    // only the state the part owns goes in: the part key, hence the sharing, depends on it alone
+    VkGraphicsPipelineCreateInfo partInfo {};
+    partInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    partInfo.flags = (pipelineInfo.flags & ~static_cast<VkPipelineCreateFlags>(VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT)) |
+        VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+    partInfo.basePipelineIndex = -1;
+
+    VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo {};
+    libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+    partInfo.pNext = &libraryInfo;
+
+    std::vector<VkPipelineShaderStageCreateInfo> stages;
+    bool renderPassState = true;
+
+    switch (part) {
+    case VertexInput:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+        partInfo.pVertexInputState = pipelineInfo.pVertexInputState;
+        partInfo.pInputAssemblyState = pipelineInfo.pInputAssemblyState;
+        partInfo.pDynamicState = pipelineInfo.pDynamicState;
+        renderPassState = false;
+        break;
+    case PreRasterization:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+        for (uint32_t i = 0; i < pipelineInfo.stageCount; i++) {
+            if (pipelineInfo.pStages[i].stage != VK_SHADER_STAGE_FRAGMENT_BIT) {
+                stages.push_back(pipelineInfo.pStages[i]);
+            }
+        }
+        partInfo.pViewportState = pipelineInfo.pViewportState;
+        partInfo.pRasterizationState = pipelineInfo.pRasterizationState;
+        partInfo.pTessellationState = pipelineInfo.pTessellationState;
+        partInfo.pDynamicState = pipelineInfo.pDynamicState;
+        partInfo.layout = pipelineInfo.layout;
+        break;
+    case FragmentShader:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+        for (uint32_t i = 0; i < pipelineInfo.stageCount; i++) {
+            if (pipelineInfo.pStages[i].stage == VK_SHADER_STAGE_FRAGMENT_BIT) {
+                stages.push_back(pipelineInfo.pStages[i]);
+            }
+        }
+        partInfo.pMultisampleState = pipelineInfo.pMultisampleState;
+        partInfo.pDepthStencilState = pipelineInfo.pDepthStencilState;
+        partInfo.pDynamicState = pipelineInfo.pDynamicState;
+        partInfo.layout = pipelineInfo.layout;
+        break;
+    case FragmentOutput:
+        libraryInfo.flags = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+        partInfo.pMultisampleState = pipelineInfo.pMultisampleState;
+        partInfo.pColorBlendState = pipelineInfo.pColorBlendState;
+        partInfo.pDynamicState = pipelineInfo.pDynamicState;
+        break;
+    default:
+        throw std::runtime_error("Invalid graphics pipeline library part.");
+    }
+
+    partInfo.stageCount = static_cast<uint32_t>(stages.size());
+    partInfo.pStages = stages.data();
+    if (renderPassState) {
+        partInfo.renderPass = pipelineInfo.renderPass;
+        partInfo.subpass = pipelineInfo.subpass;
+    }
+
+    // same canonical state key as the registry, tagged with the part
+    VulkanPipelineRegistry::StateKey key = VulkanPipelineRegistry::makeKey(partInfo, renderPassState ? formats : nullptr);
+    key.addTag(static_cast<uint32_t>(part) + 1);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_parts.find(key);
+        if (found != m_parts.end()) {
+            m_partHits.fetch_add(1, std::memory_order_relaxed);
+            return found->second;
+        }
+    }
+
+    VkPipeline pipeline;
+    if (vkCreateGraphicsPipelines(m_device, m_cache, 1, &partInfo, nullptr, &pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create graphics pipeline library.");
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto [entry, inserted] = m_parts.try_emplace(key, pipeline);
+    if (!inserted) {
+        // compiled by another thread meanwhile
+        vkDestroyPipeline(m_device, pipeline, nullptr);
+    }
+    m_partMisses.fetch_add(1, std::memory_order_relaxed);
+    return entry->second;
+#else
+    (void)part;
+    (void)pipelineInfo;
+    (void)formats;
+    return VK_NULL_HANDLE;
+#endif
+}
@@ -0,0 +1,275 @@
+#include "VulkanPipelineProvider.h"
+
+#include "MLogger.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+using namespace moo;
+
+VulkanPipelineProvider::VulkanPipelineProvider(VulkanDevice& device, VulkanPipelineCompiler& compiler) :
+    m_device{device}, m_compiler{compiler}, m_linkLibraries{device.getPipelineLibrary().isSupported()} {}
+
+VulkanPipelineProvider::~VulkanPipelineProvider() {
+    collectRetired(true);
+
+    for (Variant& variant : m_variants) {
+        if (variant.compile.valid()) {
+            try {
+                variant.pipeline = variant.compile.get();
+            } catch (const std::exception&) {
+                // nothing to release, the error already reached get() or nobody asked
+            }
+        }
+        if (variant.optimize.valid()) {
+            try {
+                releasePipeline(variant.optimize.get(), variant.request.registry);
+            } catch (const std::exception&) {
+                // the fast link is released below
+            }
+        }
+        releasePipeline(variant.pipeline, variant.request.registry);
+    }
+}
+
+VulkanPipelineProvider::Handle VulkanPipelineProvider::add(VulkanPipelineCompiler::Request request) {
+    assert(request.config != nullptr && "Cannot add a pipeline without configInfo.");
+
+    Variant variant {};
+    variant.request = std::move(request);
+    m_variants.push_back(std::move(variant));
+    m_stats.variants++;
+
+    return static_cast<Handle>(m_variants.size() - 1);
+}
+
+void VulkanPipelineProvider::replace(Handle handle, VulkanPipelineCompiler::Request request) {
+    assert(handle < m_variants.size() && "Invalid pipeline handle.");
+    assert(request.config != nullptr && "Cannot replace a pipeline without configInfo.");
+
+    Variant& variant = m_variants[handle];
+    if (variant.compile.valid()) {
+        // the worker can't be cancelled: its pipeline is released once it finishes
+        retire(std::move(variant.compile), variant.request.registry);
+        m_stats.pending--;
+    }
+    if (variant.optimize.valid()) {
+        retire(std::move(variant.optimize), variant.request.registry);
+    }
+    if (variant.pipeline != VK_NULL_HANDLE) {
+        releasePipeline(variant.pipeline, variant.request.registry);
+        m_stats.ready--;
+    }
+
+    variant = Variant{};
+    variant.request = std::move(request);
+
+    if (handle == m_fallback) {
+        this->request(variant);
+    }
+}
+
+void VulkanPipelineProvider::setFallback(Handle handle) {
+    assert((handle == INVALID_HANDLE || handle < m_variants.size()) && "Invalid pipeline handle.");
+
+    m_fallback = handle;
+    if (handle != INVALID_HANDLE && m_variants[handle].pipeline == VK_NULL_HANDLE && !m_variants[handle].compile.valid()) {
+        request(m_variants[handle]);
+    }
+}
+
+VkPipeline VulkanPipelineProvider::get(Handle handle) {
+    assert(handle < m_variants.size() && "Invalid pipeline handle.");
+
+    VkPipeline pipeline = resolve(handle);
+    if (pipeline != VK_NULL_HANDLE) {
+        return pipeline;
+    }
+
+    if (m_fallback == INVALID_HANDLE || m_fallback == handle) {
+        m_stats.skippedDraws++;
+        return VK_NULL_HANDLE;
+    }
+
+    // the fallback has to be there: waited for once, then always ready
+    Variant& fallback = m_variants[m_fallback];
+    if (fallback.pipeline == VK_NULL_HANDLE) {
+        if (!fallback.compile.valid()) {
+            request(fallback);
+        }
+        fallback.compile.wait();
+        poll(fallback);
+    }
+    pollOptimized(fallback);
+
+    m_stats.fallbackDraws++;
+    return fallback.pipeline;
+}
+
+void VulkanPipelineProvider::waitForCompiles() {
+    for (Variant& variant : m_variants) {
+        if (variant.compile.valid()) {
+            variant.compile.wait();
+        }
+        if (variant.optimize.valid()) {
+            variant.optimize.wait();
+        }
+    }
+    for (Retired& retired : m_retired) {
+        if (retired.compile.valid()) {
+            retired.compile.wait();
+        }
+    }
+}
+
+void VulkanPipelineProvider::setRenderPass(VkRenderPass renderpass) {
+    // the optimized link of a fast one copies the request: covered too
+    for (Variant& variant : m_variants) {
+        variant.request.renderpass = renderpass;
+    }
+}
+
+void VulkanPipelineProvider::beginFrame() {
+    m_frame++;
+    collectRetired(false);
+}
+
+bool VulkanPipelineProvider::hasPending() const {
+    return m_stats.pending > 0 || !m_retired.empty();
+}
+
+uint32_t VulkanPipelineProvider::getPendingFrames(Handle handle) const {
+    assert(handle < m_variants.size() && "Invalid pipeline handle.");
+    return m_variants[handle].pendingFrames;
+}
+
+void VulkanPipelineProvider::request(Variant& variant) {
+    VulkanPipelineCompiler::Request request = variant.request;
+    if (m_linkLibraries && request.link == VulkanPipelineLibrary::Link::Monolithic) {
+        request.link = VulkanPipelineLibrary::Link::Fast;
+    }
+
+    variant.compile = m_compiler.compile(std::move(request));
+    variant.requestFrame = m_frame;
+    m_stats.pending++;
+}
+
+bool VulkanPipelineProvider::poll(Variant& variant) {
+    if (variant.pipeline != VK_NULL_HANDLE) {
+        return true;
+    }
+    if (!variant.compile.valid() || variant.compile.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return false;
+    }
+
+    // get() invalidates the future, even when it rethrows the compile error
+    m_stats.pending--;
+    try {
+        variant.pipeline = variant.compile.get();
+    } catch (...) {
+        variant.error = std::current_exception();
+        throw;
+    }
+
+    variant.pendingFrames = static_cast<uint32_t>(m_frame - variant.requestFrame);
+    m_stats.ready++;
+    m_stats.maxPendingFrames = std::max(m_stats.maxPendingFrames, variant.pendingFrames);
+    m_stats.totalPendingFrames += variant.pendingFrames;
+
+    // drawn with the fast link meanwhile
+    if (m_linkLibraries && variant.request.link == VulkanPipelineLibrary::Link::Monolithic) {
+        VulkanPipelineCompiler::Request request = variant.request;
+        request.link = VulkanPipelineLibrary::Link::Optimized;
+        variant.optimize = m_compiler.compile(std::move(request));
+    }
+    return true;
+}
+
+void VulkanPipelineProvider::pollOptimized(Variant& variant) {
+    if (!variant.optimize.valid() || variant.optimize.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+
+    VkPipeline optimized;
+    try {
+        optimized = variant.optimize.get();
+    } catch (const std::exception& e) {
+        MOO_LOG_WARNING("Optimized pipeline link failed, keeping the fast link: %s", e.what());
+        return;
+    }
+
+    // the fast link may still be used by frames in flight
+    Retired retired {};
+    retired.pipeline = variant.pipeline;
+    retired.registry = variant.request.registry;
+    retired.releaseFrame = m_frame + RETIRE_FRAMES;
+    m_retired.push_back(std::move(retired));
+
+    variant.pipeline = optimized;
+    m_stats.optimized++;
+}
+
+void VulkanPipelineProvider::retire(std::future<VkPipeline> compile, VulkanPipelineRegistry* registry) {
+    Retired retired {};
+    retired.compile = std::move(compile);
+    retired.registry = registry;
+    retired.releaseFrame = m_frame;
+    m_retired.push_back(std::move(retired));
+}
+
+VkPipeline VulkanPipelineProvider::resolve(Handle handle) {
+    Variant& variant = m_variants[handle];
+
+    if (variant.error) {
+        std::rethrow_exception(variant.error);
+    }
+    if (variant.pipeline == VK_NULL_HANDLE && !variant.compile.valid()) {
+        request(variant);
+    }
+
+    if (!poll(variant)) {
+        return VK_NULL_HANDLE;
+    }
+
+    pollOptimized(variant);
+    return variant.pipeline;
+}
+
+void VulkanPipelineProvider::releasePipeline(VkPipeline pipeline, VulkanPipelineRegistry* registry) {
+    if (pipeline == VK_NULL_HANDLE) {
+        return;
+    }
+
+    if (registry) {
+        registry->release(pipeline);
+    } else {
+        vkDestroyPipeline(m_device.getDevice(), pipeline, nullptr);
+    }
+}
+
+void VulkanPipelineProvider::collectRetired(bool wait) {
+    auto finished = [this, wait](Retired& retired) {
+        if (retired.compile.valid()) {
+            if (!wait && retired.compile.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                return false;
+            }
+
+            try {
+                retired.pipeline = retired.compile.get();
+            } catch (const std::exception& e) {
+                MOO_LOG_WARNING("Replaced pipeline failed to compile: %s", e.what());
+                return true;
+            }
+        }
+
+        if (!wait && m_frame < retired.releaseFrame) {
+            return false;
+        }
+
+        releasePipeline(retired.pipeline, retired.registry);
+        return true;
+    };
+
+    m_retired.erase(std::remove_if(m_retired.begin(), m_retired.end(), finished), m_retired.end());
+}
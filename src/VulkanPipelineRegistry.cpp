@@ -0,0 +1,457 @@
+#include "VulkanPipelineRegistry.h"
+
+#include "MLogger.h"
+#include "VulkanPipelineLibrary.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace moo;
+
+namespace {
+
+// FNV-1a fed field by field: padding bytes and pNext/sType never reach the key.
+// The bytes hashed are kept, they are the key
+class StateHasher {
+public:
+    template <typename T>
+    void add(T value) {
+        static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "hash fields one by one");
+        mix(static_cast<uint64_t>(value));
+    }
+
+    void add(float value) {
+        if (value == 0.0f) {
+            value = 0.0f; // -0 and +0 are the same state
+        }
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        mix(bits);
+    }
+
+    template <typename T>
+    void addHandle(T handle) {
+        mix(reinterpret_cast<uint64_t>(handle));
+    }
+
+    void addBytes(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        mix(size);
+        for (size_t i = 0; i < size; i++) {
+            mixByte(bytes[i]);
+        }
+    }
+
+    void addString(const char* text) {
+        addBytes(text, text ? std::strlen(text) : 0);
+    }
+
+    inline VulkanPipelineRegistry::StateKey takeKey() { return std::move(m_key); }
+
+private:
+    VulkanPipelineRegistry::StateKey m_key;
+
+    void mix(uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            mixByte(static_cast<uint8_t>(value >> (i * 8)));
+        }
+    }
+
+    inline void mixByte(uint8_t byte) {
+        m_key.bytes.push_back(byte);
+        m_key.hash ^= byte;
+        m_key.hash *= 1099511628211ULL;
+    }
+};
+
+bool isDynamic(const VkPipelineDynamicStateCreateInfo* dynamicState, VkDynamicState state) {
+    if (!dynamicState) {
+        return false;
+    }
+    return std::find(dynamicState->pDynamicStates, dynamicState->pDynamicStates + dynamicState->dynamicStateCount, state) !=
+        dynamicState->pDynamicStates + dynamicState->dynamicStateCount;
+}
+
+// with a dynamic topology only the class of the baked one has to match
+uint32_t topologyClass(VkPrimitiveTopology topology) {
+    switch (topology) {
+    case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+        return 0;
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+    case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+        return 1;
+    case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+const VkShaderModuleCreateInfo* findInlineModule(const void* next) {
+    while (next) {
+        const VkBaseInStructure* base = static_cast<const VkBaseInStructure*>(next);
+        if (base->sType == VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO) {
+            return static_cast<const VkShaderModuleCreateInfo*>(next);
+        }
+        next = base->pNext;
+    }
+    return nullptr;
+}
+
+void hashStage(StateHasher& hasher, const VkPipelineShaderStageCreateInfo& stage) {
+    hasher.add(stage.flags);
+    hasher.add(stage.stage);
+    hasher.addString(stage.pName);
+
+    if (stage.module != VK_NULL_HANDLE) {
+        hasher.addHandle(stage.module);
+    } else if (const VkShaderModuleCreateInfo* code = findInlineModule(stage.pNext)) {
+        hasher.addBytes(code->pCode, code->codeSize);
+    }
+
+    if (const VkSpecializationInfo* specialization = stage.pSpecializationInfo) {
+        hasher.add(specialization->mapEntryCount);
+        for (uint32_t i = 0; i < specialization->mapEntryCount; i++) {
+            hasher.add(specialization->pMapEntries[i].constantID);
+            hasher.add(specialization->pMapEntries[i].offset);
+            hasher.add(specialization->pMapEntries[i].size);
+        }
+        hasher.addBytes(specialization->pData, specialization->dataSize);
+    }
+}
+
+void hashVertexInput(StateHasher& hasher, const VkPipelineVertexInputStateCreateInfo* vertexInput) {
+    if (!vertexInput) {
+        hasher.add(0u);
+        return;
+    }
+
+    hasher.add(vertexInput->vertexBindingDescriptionCount);
+    for (uint32_t i = 0; i < vertexInput->vertexBindingDescriptionCount; i++) {
+        const VkVertexInputBindingDescription& binding = vertexInput->pVertexBindingDescriptions[i];
+        hasher.add(binding.binding);
+        hasher.add(binding.stride);
+        hasher.add(binding.inputRate);
+    }
+
+    hasher.add(vertexInput->vertexAttributeDescriptionCount);
+    for (uint32_t i = 0; i < vertexInput->vertexAttributeDescriptionCount; i++) {
+        const VkVertexInputAttributeDescription& attribute = vertexInput->pVertexAttributeDescriptions[i];
+        hasher.add(attribute.location);
+        hasher.add(attribute.binding);
+        hasher.add(attribute.format);
+        hasher.add(attribute.offset);
+    }
+}
+
+void hashViewport(StateHasher& hasher, const VkPipelineViewportStateCreateInfo* viewport, const VkPipelineDynamicStateCreateInfo* dynamicState) {
+    if (!viewport) {
+        hasher.add(0u);
+        return;
+    }
+
+    hasher.add(viewport->viewportCount);
+    hasher.add(viewport->scissorCount);
+
+    // dynamic viewport/scissor: the static values are ignored by the driver, so by the key too
+    if (viewport->pViewports && !isDynamic(dynamicState, VK_DYNAMIC_STATE_VIEWPORT)) {
+        for (uint32_t i = 0; i < viewport->viewportCount; i++) {
+            const VkViewport& v = viewport->pViewports[i];
+            hasher.add(v.x); hasher.add(v.y); hasher.add(v.width); hasher.add(v.height);
+            hasher.add(v.minDepth); hasher.add(v.maxDepth);
+        }
+    }
+    if (viewport->pScissors && !isDynamic(dynamicState, VK_DYNAMIC_STATE_SCISSOR)) {
+        for (uint32_t i = 0; i < viewport->scissorCount; i++) {
+            const VkRect2D& s = viewport->pScissors[i];
+            hasher.add(s.offset.x); hasher.add(s.offset.y); hasher.add(s.extent.width); hasher.add(s.extent.height);
+        }
+    }
+}
+
+void hashRasterization(StateHasher& hasher, const VkPipelineRasterizationStateCreateInfo* raster, const VkPipelineDynamicStateCreateInfo* dynamicState) {
+    if (!raster) {
+        hasher.add(0u);
+        return;
+    }
+
+    hasher.add(raster->flags);
+    hasher.add(raster->depthClampEnable);
+    hasher.add(raster->rasterizerDiscardEnable);
+    hasher.add(raster->polygonMode);
+    if (!isDynamic(dynamicState, VK_DYNAMIC_STATE_CULL_MODE)) {
+        hasher.add(raster->cullMode);
+    }
+    if (!isDynamic(dynamicState, VK_DYNAMIC_STATE_FRONT_FACE)) {
+        hasher.add(raster->frontFace);
+    }
+    hasher.add(raster->depthBiasEnable);
+    if (raster->depthBiasEnable && !isDynamic(dynamicState, VK_DYNAMIC_STATE_DEPTH_BIAS)) {
+        hasher.add(raster->depthBiasConstantFactor);
+        hasher.add(raster->depthBiasClamp);
+        hasher.add(raster->depthBiasSlopeFactor);
+    }
+    if (!isDynamic(dynamicState, VK_DYNAMIC_STATE_LINE_WIDTH)) {
+        hasher.add(raster->lineWidth);
+    }
+}
+
+void hashMultisample(StateHasher& hasher, const VkPipelineMultisampleStateCreateInfo* multisample) {
+    if (!multisample) {
+        hasher.add(0u);
+        return;
+    }
+
+    hasher.add(multisample->rasterizationSamples);
+    hasher.add(multisample->sampleShadingEnable);
+    if (multisample->sampleShadingEnable) {
+        hasher.add(multisample->minSampleShading);
+    }
+    if (multisample->pSampleMask) {
+        uint32_t words = (static_cast<uint32_t>(multisample->rasterizationSamples) + 31) / 32;
+        hasher.addBytes(multisample->pSampleMask, words * sizeof(VkSampleMask));
+    }
+    hasher.add(multisample->alphaToCoverageEnable);
+    hasher.add(multisample->alphaToOneEnable);
+}
+
+void hashStencilOp(StateHasher& hasher, const VkStencilOpState& op) {
+    hasher.add(op.failOp);
+    hasher.add(op.passOp);
+    hasher.add(op.depthFailOp);
+    hasher.add(op.compareOp);
+    hasher.add(op.compareMask);
+    hasher.add(op.writeMask);
+    hasher.add(op.reference);
+}
+
+void hashDepthStencil(StateHasher& hasher, const VkPipelineDepthStencilStateCreateInfo* depthStencil, const VkPipelineDynamicStateCreateInfo* dynamicState) {
+    if (!depthStencil) {
+        hasher.add(0u);
+        return;
+    }
+
+    if (!isDynamic(dynamicState, VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE)) {
+        hasher.add(depthStencil->depthTestEnable);
+    }
+    if (!isDynamic(dynamicState, VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE)) {
+        hasher.add(depthStencil->depthWriteEnable);
+    }
+    if (!isDynamic(dynamicState, VK_DYNAMIC_STATE_DEPTH_COMPARE_OP)) {
+        hasher.add(depthStencil->depthCompareOp);
+    }
+    hasher.add(depthStencil->depthBoundsTestEnable);
+    hasher.add(depthStencil->stencilTestEnable);
+    if (depthStencil->stencilTestEnable) {
+        hashStencilOp(hasher, depthStencil->front);
+        hashStencilOp(hasher, depthStencil->back);
+    }
+    if (depthStencil->depthBoundsTestEnable) {
+        hasher.add(depthStencil->minDepthBounds);
+        hasher.add(depthStencil->maxDepthBounds);
+    }
+}
+
+void hashColorBlend(StateHasher& hasher, const VkPipelineColorBlendStateCreateInfo* colorBlend, const VkPipelineDynamicStateCreateInfo* dynamicState) {
+    if (!colorBlend) {
+        hasher.add(0u);
+        return;
+    }
+
+    hasher.add(colorBlend->logicOpEnable);
+    if (colorBlend->logicOpEnable) {
+        hasher.add(colorBlend->logicOp);
+    }
+
+    hasher.add(colorBlend->attachmentCount);
+    for (uint32_t i = 0; i < colorBlend->attachmentCount; i++) {
+        const VkPipelineColorBlendAttachmentState& attachment = colorBlend->pAttachments[i];
+        hasher.add(attachment.blendEnable);
+        if (attachment.blendEnable) {
+            hasher.add(attachment.srcColorBlendFactor);
+            hasher.add(attachment.dstColorBlendFactor);
+            hasher.add(attachment.colorBlendOp);
+            hasher.add(attachment.srcAlphaBlendFactor);
+            hasher.add(attachment.dstAlphaBlendFactor);
+            hasher.add(attachment.alphaBlendOp);
+        }
+        hasher.add(attachment.colorWriteMask);
+    }
+
+    if (!isDynamic(dynamicState, VK_DYNAMIC_STATE_BLEND_CONSTANTS)) {
+        for (float constant : colorBlend->blendConstants) {
+            hasher.add(constant);
+        }
+    }
+}
+
+void hashDynamicStates(StateHasher& hasher, const VkPipelineDynamicStateCreateInfo* dynamicState) {
+    if (!dynamicState) {
+        hasher.add(0u);
+        return;
+    }
+
+    // order doesn't matter to Vulkan, it mustn't matter to the key
+    std::vector<VkDynamicState> states(dynamicState->pDynamicStates, dynamicState->pDynamicStates + dynamicState->dynamicStateCount);
+    std::sort(states.begin(), states.end());
+
+    hasher.add(static_cast<uint32_t>(states.size()));
+    for (VkDynamicState state : states) {
+        hasher.add(state);
+    }
+}
+
+}   // namespace
+
+VulkanPipelineRegistry::VulkanPipelineRegistry(VkDevice device, VkPipelineCache cache) : m_device{device}, m_cache{cache} {}
+
+VulkanPipelineRegistry::~VulkanPipelineRegistry() {
+    if (!m_entries.empty()) {
+        MOO_LOG_WARNING("%zu pipelines still referenced at registry destruction", m_entries.size());
+    }
+
+    for (auto& [key, entry] : m_entries) {
+        vkDestroyPipeline(m_device, entry.pipeline, nullptr);
+    }
+}
+
+void VulkanPipelineRegistry::StateKey::addTag(uint32_t tag) {
+    for (int i = 0; i < 4; i++) {
+        bytes.push_back(static_cast<uint8_t>(tag >> (i * 8)));
+    }
+    hash = (hash ^ tag) * 1099511628211ULL;
+}
+
+VulkanPipelineRegistry::StateKey VulkanPipelineRegistry::makeKey(const VkGraphicsPipelineCreateInfo& pipelineInfo, const AttachmentFormats* formats) {
+    StateHasher hasher;
+    const VkPipelineDynamicStateCreateInfo* dynamicState = pipelineInfo.pDynamicState;
+
+    hasher.add(pipelineInfo.flags);
+
+    hasher.add(pipelineInfo.stageCount);
+    for (uint32_t i = 0; i < pipelineInfo.stageCount; i++) {
+        hashStage(hasher, pipelineInfo.pStages[i]);
+    }
+
+    hashVertexInput(hasher, pipelineInfo.pVertexInputState);
+
+    if (const VkPipelineInputAssemblyStateCreateInfo* inputAssembly = pipelineInfo.pInputAssemblyState) {
+        if (isDynamic(dynamicState, VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY)) {
+            hasher.add(topologyClass(inputAssembly->topology));
+        } else {
+            hasher.add(inputAssembly->topology);
+        }
+        hasher.add(inputAssembly->primitiveRestartEnable);
+    } else {
+        hasher.add(0u);
+    }
+
+    if (const VkPipelineTessellationStateCreateInfo* tessellation = pipelineInfo.pTessellationState) {
+        hasher.add(tessellation->patchControlPoints);
+    } else {
+        hasher.add(0u);
+    }
+
+    hashViewport(hasher, pipelineInfo.pViewportState, dynamicState);
+    hashRasterization(hasher, pipelineInfo.pRasterizationState, dynamicState);
+    hashMultisample(hasher, pipelineInfo.pMultisampleState);
+    hashDepthStencil(hasher, pipelineInfo.pDepthStencilState, dynamicState);
+    hashColorBlend(hasher, pipelineInfo.pColorBlendState, dynamicState);
+    hashDynamicStates(hasher, dynamicState);
+
+    hasher.addHandle(pipelineInfo.layout);
+
+    if (formats) {
+        hasher.add(static_cast<uint32_t>(formats->color.size()));
+        for (VkFormat format : formats->color) {
+            hasher.add(format);
+        }
+        hasher.add(formats->depth);
+        hasher.add(formats->samples);
+    } else {
+        hasher.addHandle(pipelineInfo.renderPass);
+    }
+    hasher.add(pipelineInfo.subpass);
+
+    return hasher.takeKey();
+}
+
+VkPipeline VulkanPipelineRegistry::acquire(const VkGraphicsPipelineCreateInfo& pipelineInfo, const AttachmentFormats* formats,
+    VulkanPipelineLibrary* library, bool optimize)
+{
+    if (library && !library->isSupported()) {
+        library = nullptr;
+    }
+
+    StateKey key = makeKey(pipelineInfo, formats);
+    if (library) {
+        // fast links are slower to draw with: never handed out for a monolithic or optimized request
+        key.addTag(optimize ? 2u : 1u);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto found = m_entries.find(key);
+        if (found != m_entries.end()) {
+            found->second.references++;
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return found->second.pipeline;
+        }
+    }
+
+    // compiled without holding the lock, other states keep compiling in parallel
+    VkPipeline pipeline;
+    if (library) {
+        pipeline = library->link(pipelineInfo, formats, optimize);
+    } else if (vkCreateGraphicsPipelines(m_device, m_cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create graphics pipeline.");
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto [entry, inserted] = m_entries.try_emplace(key);
+    if (!inserted) {
+        // another thread compiled the same state meanwhile, keep the first one
+        vkDestroyPipeline(m_device, pipeline, nullptr);
+        entry->second.references++;
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return entry->second.pipeline;
+    }
+
+    entry->second.pipeline = pipeline;
+    entry->second.references = 1;
+    m_keys.emplace(pipeline, std::move(key));
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return pipeline;
+}
+
+void VulkanPipelineRegistry::release(VkPipeline pipeline) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto key = m_keys.find(pipeline);
+    if (key == m_keys.end()) {
+        assert(false && "Releasing a pipeline the registry doesn't own.");
+        return;
+    }
+
+    auto entry = m_entries.find(key->second);
+    if (--entry->second.references == 0) {
+        vkDestroyPipeline(m_device, pipeline, nullptr);
+        m_entries.erase(entry);
+        m_keys.erase(key);
+    }
+}
+
+VulkanPipelineRegistry::Stats VulkanPipelineRegistry::getStats() {
+    Stats stats {};
+    stats.hits = m_hits.load(std::memory_order_relaxed);
+    stats.misses = m_misses.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    stats.pipelines = static_cast<uint32_t>(m_entries.size());
+    return stats;
+}
@@ -0,0 +1,104 @@
+#include "VulkanRenderQueue.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+using namespace moo;
+
+namespace {
+
+constexpr uint64_t fieldMask(uint32_t bits) { return (uint64_t{1} << bits) - 1; }
+
+}   // namespace
+
+uint64_t VulkanRenderQueue::makeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, uint16_t depth) {
+    uint64_t key = pass & fieldMask(PASS_BITS);
+    key = (key << PIPELINE_BITS) | (pipeline & fieldMask(PIPELINE_BITS));
+    key = (key << MATERIAL_BITS) | (material & fieldMask(MATERIAL_BITS));
+    key = (key << MESH_BITS) | (mesh & fieldMask(MESH_BITS));
+    key = (key << DEPTH_BITS) | depth;
+    return key;
+}
+
+uint16_t VulkanRenderQueue::quantizeDepth(float depth, bool backToFront) {
+    float clamped = std::min(std::max(depth, 0.0f), 1.0f);
+    uint16_t quantized = static_cast<uint16_t>(std::lround(clamped * static_cast<float>(fieldMask(DEPTH_BITS))));
+    return backToFront ? static_cast<uint16_t>(fieldMask(DEPTH_BITS) - quantized) : quantized;
+}
+
+void VulkanRenderQueue::clear() {
+    m_draws.clear();
+    m_entries.clear();
+}
+
+void VulkanRenderQueue::reserve(size_t drawCount) {
+    m_draws.reserve(drawCount);
+    m_entries.reserve(drawCount);
+    m_scratch.reserve(drawCount);
+}
+
+void VulkanRenderQueue::push(uint64_t key, const Draw& draw) {
+    m_entries.push_back({key, static_cast<uint32_t>(m_draws.size())});
+    m_draws.push_back(draw);
+}
+
+void VulkanRenderQueue::sort() {
+    const size_t count = m_entries.size();
+    if (count < 2) {
+        return;
+    }
+    m_scratch.resize(count);
+
+    // every digit's histogram in one read of the keys
+    std::array<std::array<uint32_t, 256>, 8> histograms {};
+    for (const Entry& entry : m_entries) {
+        for (uint32_t digit = 0; digit < 8; digit++) {
+            histograms[digit][(entry.key >> (digit * 8)) & 0xff]++;
+        }
+    }
+
+    Entry* source = m_entries.data();
+    Entry* destination = m_scratch.data();
+    for (uint32_t digit = 0; digit < 8; digit++) {
+        std::array<uint32_t, 256>& histogram = histograms[digit];
+
+        // every key has the same byte here (unused fields, few pipelines): nothing to move
+        if (histogram[(source[0].key >> (digit * 8)) & 0xff] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t& bucket : histogram) {
+            uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            destination[histogram[(source[i].key >> (digit * 8)) & 0xff]++] = source[i];
+        }
+        std::swap(source, destination);
+    }
+
+    // odd number of passes: the result is in the scratch buffer
+    if (source != m_entries.data()) {
+        m_entries.swap(m_scratch);
+    }
+}
+
+void VulkanRenderQueue::submit(VulkanCommandEncoder& encoder) {
+    for (const Entry& entry : m_entries) {
+        const Draw& draw = m_draws[entry.draw];
+
+        encoder.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, draw.pipeline, draw.dynamicStates);
+        if (draw.material != VK_NULL_HANDLE) {
+            encoder.bindDescriptorSets(VK_PIPELINE_BIND_POINT_GRAPHICS, draw.layout, 0, 1, &draw.material);
+        }
+        if (draw.pushConstants) {
+            encoder.push<VulkanModel::PushBlock>(draw.layout, draw.constants);
+        }
+        draw.model->bind(encoder);
+        draw.model->draw(encoder.getCommandBuffer(), draw.instanceCount, draw.firstInstance, draw.lod);
+    }
+}
@@ -0,0 +1,119 @@
+#include "VulkanShaderCache.h"
+
+#include "vk_initializers.h"
+#include "MLogger.h"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace moo;
+
+VulkanShaderCache::VulkanShaderCache(VkDevice device, bool inlineModules) : m_device{device}, m_inlineModules{inlineModules} {}
+
+VulkanShaderCache::~VulkanShaderCache() {
+    for (auto& entry : m_entries) {
+        if (entry->module != VK_NULL_HANDLE) {
+            vkDestroyShaderModule(m_device, entry->module, nullptr);
+        }
+    }
+}
+
+VulkanShaderCache::Entry& VulkanShaderCache::load(const std::string& filepath) {
+    auto known = m_byPath.find(filepath);
+    if (known != m_byPath.end()) {
+        return *known->second;
+    }
+
+    MFileMapping file(filepath);
+    if (file.size() % sizeof(uint32_t) != 0) {
+        throw std::runtime_error("Invalid SPIR-V size: " + filepath);
+    }
+
+    uint64_t hash = hashCode(file.data(), file.size());
+
+    // same bytes under another path (copies, symlinks): share the module
+    auto same = m_byHash.find(hash);
+    if (same != m_byHash.end() && same->second->file.size() == file.size() &&
+        std::memcmp(same->second->file.data(), file.data(), file.size()) == 0) {
+        m_byPath.emplace(filepath, same->second);
+        return *same->second;
+    }
+
+    auto entry = std::make_unique<Entry>();
+    entry->file = std::move(file);
+    entry->hash = hash;
+
+    // a mapping is page aligned, so the code can be handed over without a copy
+    entry->createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    entry->createInfo.codeSize = entry->file.size();
+    entry->createInfo.pCode = static_cast<const uint32_t*>(entry->file.data());
+
+    try {
+        entry->reflection = std::make_unique<VulkanShaderReflection>(entry->createInfo.pCode, entry->file.size() / sizeof(uint32_t));
+    } catch (const std::runtime_error& error) {
+        throw std::runtime_error(std::string(error.what()) + " (" + filepath + ")");
+    }
+
+    if (!m_inlineModules) {
+        createModule(*entry, filepath);
+    }
+
+    MOO_LOG_DEBUG("shader %s loaded: %zu bytes, hash %016llx", filepath.c_str(), entry->file.size(),
+        static_cast<unsigned long long>(hash));
+
+    Entry* loaded = entry.get();
+    m_entries.push_back(std::move(entry));
+    m_byPath.emplace(filepath, loaded);
+    m_byHash.emplace(hash, loaded); // keeps the first entry on a (very unlikely) collision
+    return *loaded;
+}
+
+VkShaderModule VulkanShaderCache::createModule(Entry& entry, const std::string& filepath) {
+    if (entry.module == VK_NULL_HANDLE) {
+        if (vkCreateShaderModule(m_device, &entry.createInfo, nullptr, &entry.module) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create shader module: " + filepath);
+        }
+    }
+    return entry.module;
+}
+
+VkShaderModule VulkanShaderCache::getModule(const std::string& filepath) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // explicitly asked for a module: create it even in inline mode
+    return createModule(load(filepath), filepath);
+}
+
+VkPipelineShaderStageCreateInfo VulkanShaderCache::getStageInfo(const std::string& filepath, VkShaderStageFlagBits stage) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Entry& entry = load(filepath);
+
+    if (m_inlineModules && entry.module == VK_NULL_HANDLE) {
+        VkPipelineShaderStageCreateInfo info = vkinit::pipelineShaderStageCreateInfo(stage, VK_NULL_HANDLE);
+        info.pNext = &entry.createInfo;
+        return info;
+    }
+
+    return vkinit::pipelineShaderStageCreateInfo(stage, createModule(entry, filepath));
+}
+
+uint64_t VulkanShaderCache::getHash(const std::string& filepath) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return load(filepath).hash;
+}
+
+const VulkanShaderReflection& VulkanShaderCache::getReflection(const std::string& filepath) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return *load(filepath).reflection;
+}
+
+uint64_t VulkanShaderCache::hashCode(const void* data, size_t size) {
+    // FNV-1a over 32 bit words, SPIR-V is always a whole number of words
+    const uint32_t* words = static_cast<const uint32_t*>(data);
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size / sizeof(uint32_t); i++) {
+        hash ^= words[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
@@ -0,0 +1,452 @@
+#include "VulkanShaderReflection.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace moo;
+
+namespace {
+
+// the few SPIR-V enums reflection needs (SPIR-V 1.6 specification)
+constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+constexpr uint32_t SPIRV_HEADER_WORDS = 5;
+
+enum Op : uint32_t {
+    OpEntryPoint = 15,
+    OpExecutionMode = 16,
+    OpTypeBool = 20,
+    OpTypeInt = 21,
+    OpTypeFloat = 22,
+    OpTypeVector = 23,
+    OpTypeMatrix = 24,
+    OpTypeImage = 25,
+    OpTypeSampler = 26,
+    OpTypeSampledImage = 27,
+    OpTypeArray = 28,
+    OpTypeRuntimeArray = 29,
+    OpTypeStruct = 30,
+    OpTypePointer = 32,
+    OpConstant = 43,
+    OpVariable = 59,
+    OpDecorate = 71,
+    OpMemberDecorate = 72,
+    OpTypeAccelerationStructureKHR = 5341,
+};
+
+enum Decoration : uint32_t {
+    DecorationBufferBlock = 3,
+    DecorationArrayStride = 6,
+    DecorationMatrixStride = 7,
+    DecorationBuiltIn = 11,
+    DecorationLocation = 30,
+    DecorationBinding = 33,
+    DecorationDescriptorSet = 34,
+    DecorationOffset = 35,
+};
+
+enum StorageClass : uint32_t {
+    StorageUniformConstant = 0,
+    StorageInput = 1,
+    StorageUniform = 2,
+    StoragePushConstant = 9,
+    StorageStorageBuffer = 12,
+};
+
+constexpr uint32_t EXECUTION_MODE_LOCAL_SIZE = 17;
+constexpr uint32_t DIM_BUFFER = 5;
+constexpr uint32_t DIM_SUBPASS_DATA = 6;
+constexpr uint32_t NONE = ~0u;
+
+struct Id {
+    uint32_t op = 0;
+    // type: component/element/pointee type, constant: value
+    uint32_t type = NONE;
+    uint32_t count = 0;         // vector/matrix size, array length id, int/float width
+    uint32_t storageClass = NONE;
+    uint32_t imageDim = 0;
+    uint32_t imageSampled = 0;
+    bool isSigned = false;
+    std::vector<uint32_t> members;
+
+    // decorations
+    uint32_t set = NONE;
+    uint32_t binding = NONE;
+    uint32_t location = NONE;
+    uint32_t arrayStride = 0;
+    bool builtIn = false;
+    bool bufferBlock = false;
+    std::vector<uint32_t> memberOffsets;
+    std::vector<uint32_t> memberMatrixStrides;
+};
+
+VkShaderStageFlagBits toStage(uint32_t executionModel) {
+    switch (executionModel) {
+    case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+    case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+    case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+    case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+    case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+    case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+    default:
+        throw std::runtime_error("Failed to reflect shader: unsupported execution model.");
+    }
+}
+
+class Reflector {
+public:
+    std::vector<Id> ids;
+
+    uint32_t sizeOf(uint32_t typeId, uint32_t matrixStride = 0) const {
+        const Id& type = ids[typeId];
+        switch (type.op) {
+        case OpTypeBool:
+            return 4;
+        case OpTypeInt:
+        case OpTypeFloat:
+            return type.count / 8;
+        case OpTypeVector:
+            return type.count * sizeOf(type.type);
+        case OpTypeMatrix:
+            return type.count * (matrixStride ? matrixStride : sizeOf(type.type));
+        case OpTypeArray: {
+            uint32_t length = ids[type.count].type;
+            uint32_t stride = type.arrayStride ? type.arrayStride : sizeOf(type.type, matrixStride);
+            return length * stride;
+        }
+        case OpTypeRuntimeArray:
+            return 0;
+        case OpTypeStruct: {
+            uint32_t size = 0;
+            uint32_t offset = 0;
+            for (size_t i = 0; i < type.members.size(); i++) {
+                if (i < type.memberOffsets.size() && type.memberOffsets[i] != NONE) {
+                    offset = type.memberOffsets[i];
+                }
+                uint32_t stride = i < type.memberMatrixStrides.size() ? type.memberMatrixStrides[i] : 0;
+                offset += sizeOf(type.members[i], stride);
+                size = std::max(size, offset);
+            }
+            return size;
+        }
+        default:
+            return 0;
+        }
+    }
+
+    VkDescriptorType descriptorType(const Id& variable, uint32_t typeId) const {
+        const Id& type = ids[typeId];
+        switch (variable.storageClass) {
+        case StorageStorageBuffer:
+            return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        case StorageUniform:
+            // SPIR-V 1.0 storage buffers: Uniform storage class, BufferBlock struct
+            return type.bufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        default:
+            break;
+        }
+
+        switch (type.op) {
+        case OpTypeSampler:
+            return VK_DESCRIPTOR_TYPE_SAMPLER;
+        case OpTypeSampledImage: {
+            const Id& image = ids[type.type];
+            return image.imageDim == DIM_BUFFER ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        }
+        case OpTypeImage:
+            if (type.imageDim == DIM_BUFFER) {
+                return type.imageSampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+            }
+            if (type.imageDim == DIM_SUBPASS_DATA) {
+                return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            }
+            return type.imageSampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+#ifdef VK_KHR_acceleration_structure
+        case OpTypeAccelerationStructureKHR:
+            return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+#endif
+        default:
+            throw std::runtime_error("Failed to reflect shader: unsupported descriptor type.");
+        }
+    }
+
+    VkFormat vertexFormat(uint32_t typeId) const {
+        const Id& type = ids[typeId];
+        uint32_t components = 1;
+        const Id* scalar = &type;
+        if (type.op == OpTypeVector) {
+            components = type.count;
+            scalar = &ids[type.type];
+        }
+
+        static constexpr VkFormat FLOATS[] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+        static constexpr VkFormat INTS[] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+        static constexpr VkFormat UINTS[] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+        if (components < 1 || components > 4 || scalar->count != 32) {
+            throw std::runtime_error("Failed to reflect shader: unsupported vertex input type.");
+        }
+
+        if (scalar->op == OpTypeFloat) {
+            return FLOATS[components - 1];
+        }
+        if (scalar->op == OpTypeInt) {
+            return scalar->isSigned ? INTS[components - 1] : UINTS[components - 1];
+        }
+        throw std::runtime_error("Failed to reflect shader: unsupported vertex input type.");
+    }
+};
+
+}   // namespace
+
+VulkanShaderReflection::VulkanShaderReflection(const uint32_t* code, size_t wordCount) {
+    if (wordCount < SPIRV_HEADER_WORDS || code[0] != SPIRV_MAGIC) {
+        throw std::runtime_error("Failed to reflect shader: not a SPIR-V module.");
+    }
+
+    Reflector reflector;
+    std::vector<Id>& ids = reflector.ids;
+    ids.resize(code[3]);    // id bound
+
+    bool entryPointFound = false;
+    uint32_t entryPoint = NONE;
+    std::vector<uint32_t> variables;
+
+    // every instruction: high half word count, low half opcode
+    for (size_t at = SPIRV_HEADER_WORDS; at < wordCount;) {
+        uint32_t length = code[at] >> 16;
+        uint32_t op = code[at] & 0xffff;
+        if (length == 0 || at + length > wordCount) {
+            throw std::runtime_error("Failed to reflect shader: truncated SPIR-V module.");
+        }
+        const uint32_t* operands = code + at + 1;
+        auto id = [&](uint32_t operand) -> Id& {
+            if (operand >= length - 1 || operands[operand] >= ids.size()) {
+                throw std::runtime_error("Failed to reflect shader: invalid SPIR-V id.");
+            }
+            return ids[operands[operand]];
+        };
+
+        switch (op) {
+        case OpEntryPoint:
+            if (!entryPointFound) {
+                m_stage = toStage(operands[0]);
+                entryPoint = operands[1];
+                entryPointFound = true;
+            }
+            break;
+        case OpExecutionMode:
+            if (operands[0] == entryPoint && operands[1] == EXECUTION_MODE_LOCAL_SIZE && length >= 6) {
+                m_localSize = {operands[2], operands[3], operands[4]};
+            }
+            break;
+        case OpTypeBool:
+        case OpTypeSampler:
+        case OpTypeAccelerationStructureKHR:
+            id(0).op = op;
+            break;
+        case OpTypeInt:
+            id(0).op = op;
+            id(0).count = operands[1];
+            id(0).isSigned = operands[2] != 0;
+            break;
+        case OpTypeFloat:
+            id(0).op = op;
+            id(0).count = operands[1];
+            break;
+        case OpTypeVector:
+        case OpTypeMatrix:
+        case OpTypeArray:
+            id(0).op = op;
+            id(0).type = operands[1];
+            id(0).count = operands[2];
+            break;
+        case OpTypeRuntimeArray:
+        case OpTypeSampledImage:
+            id(0).op = op;
+            id(0).type = operands[1];
+            break;
+        case OpTypeImage:
+            id(0).op = op;
+            id(0).type = operands[1];
+            id(0).imageDim = operands[2];
+            id(0).imageSampled = operands[6];
+            break;
+        case OpTypeStruct:
+            id(0).op = op;
+            id(0).members.assign(operands + 1, operands + length - 1);
+            break;
+        case OpTypePointer:
+            id(0).op = op;
+            id(0).storageClass = operands[1];
+            id(0).type = operands[2];
+            break;
+        case OpConstant:
+            // 32 bit is enough for array lengths
+            id(1).op = op;
+            id(1).type = operands[2];
+            break;
+        case OpVariable:
+            id(1).op = op;
+            id(1).type = operands[0];
+            id(1).storageClass = operands[2];
+            variables.push_back(operands[1]);
+            break;
+        case OpDecorate: {
+            Id& target = id(0);
+            switch (operands[1]) {
+            case DecorationBufferBlock: target.bufferBlock = true; break;
+            case DecorationArrayStride: target.arrayStride = operands[2]; break;
+            case DecorationBuiltIn: target.builtIn = true; break;
+            case DecorationLocation: target.location = operands[2]; break;
+            case DecorationBinding: target.binding = operands[2]; break;
+            case DecorationDescriptorSet: target.set = operands[2]; break;
+            default: break;
+            }
+            break;
+        }
+        case OpMemberDecorate: {
+            Id& target = id(0);
+            uint32_t member = operands[1];
+            if (operands[2] == DecorationOffset) {
+                target.memberOffsets.resize(std::max<size_t>(target.memberOffsets.size(), member + 1), NONE);
+                target.memberOffsets[member] = operands[3];
+            } else if (operands[2] == DecorationMatrixStride) {
+                target.memberMatrixStrides.resize(std::max<size_t>(target.memberMatrixStrides.size(), member + 1), 0);
+                target.memberMatrixStrides[member] = operands[3];
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        at += length;
+    }
+
+    if (!entryPointFound) {
+        throw std::runtime_error("Failed to reflect shader: no entry point.");
+    }
+
+    for (uint32_t variableId : variables) {
+        const Id& variable = ids[variableId];
+        const Id& pointer = ids[variable.type];
+        if (pointer.op != OpTypePointer) {
+            continue;
+        }
+        uint32_t typeId = pointer.type;
+
+        switch (variable.storageClass) {
+        case StorageUniformConstant:
+        case StorageUniform:
+        case StorageStorageBuffer: {
+            if (variable.binding == NONE) {
+                continue;
+            }
+            DescriptorBinding binding {};
+            binding.set = variable.set == NONE ? 0 : variable.set;
+            binding.binding = variable.binding;
+            binding.stages = m_stage;
+            if (ids[typeId].op == OpTypeArray) {
+                binding.count = ids[ids[typeId].count].type;
+                typeId = ids[typeId].type;
+            } else if (ids[typeId].op == OpTypeRuntimeArray) {
+                binding.count = 0;
+                typeId = ids[typeId].type;
+            }
+            binding.type = reflector.descriptorType(variable, typeId);
+            m_bindings.push_back(binding);
+            break;
+        }
+        case StoragePushConstant: {
+            const Id& block = ids[typeId];
+            uint32_t offset = NONE;
+            for (uint32_t memberOffset : block.memberOffsets) {
+                offset = std::min(offset, memberOffset);
+            }
+            offset = offset == NONE ? 0 : offset;
+            uint32_t end = reflector.sizeOf(typeId);
+            m_pushConstants.stageFlags = m_stage;
+            m_pushConstants.offset = offset;
+            // ranges are a multiple of 4 bytes
+            m_pushConstants.size = ((end - offset) + 3) & ~3u;
+            break;
+        }
+        case StorageInput: {
+            if (m_stage != VK_SHADER_STAGE_VERTEX_BIT || variable.builtIn || variable.location == NONE) {
+                continue;
+            }
+            const Id& type = ids[typeId];
+            if (type.op == OpTypeMatrix) {
+                VkFormat column = reflector.vertexFormat(type.type);
+                for (uint32_t i = 0; i < type.count; i++) {
+                    m_vertexInputs.push_back({variable.location + i, column});
+                }
+            } else {
+                m_vertexInputs.push_back({variable.location, reflector.vertexFormat(typeId)});
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    std::sort(m_bindings.begin(), m_bindings.end(), [](const DescriptorBinding& a, const DescriptorBinding& b) {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+    std::sort(m_vertexInputs.begin(), m_vertexInputs.end(), [](const VertexInput& a, const VertexInput& b) {
+        return a.location < b.location;
+    });
+}
+
+std::vector<VkVertexInputAttributeDescription> VulkanShaderReflection::getVertexAttributes(uint32_t binding, uint32_t* stride) const {
+    std::vector<VkVertexInputAttributeDescription> attributes;
+    uint32_t offset = 0;
+    for (const VertexInput& input : m_vertexInputs) {
+        VkVertexInputAttributeDescription attribute {};
+        attribute.binding = binding;
+        attribute.location = input.location;
+        attribute.format = input.format;
+        attribute.offset = offset;
+        attributes.push_back(attribute);
+        offset += formatSize(input.format);
+    }
+
+    if (stride) {
+        *stride = offset;
+    }
+    return attributes;
+}
+
+bool VulkanShaderReflection::matchesVertexAttributes(const std::vector<VkVertexInputAttributeDescription>& attributes) const {
+    for (const VertexInput& input : m_vertexInputs) {
+        auto found = std::find_if(attributes.begin(), attributes.end(),
+            [&input](const VkVertexInputAttributeDescription& a) { return a.location == input.location; });
+        if (found == attributes.end() || found->format != input.format) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t VulkanShaderReflection::formatSize(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_R32_SFLOAT:
+    case VK_FORMAT_R32_SINT:
+    case VK_FORMAT_R32_UINT:
+        return 4;
+    case VK_FORMAT_R32G32_SFLOAT:
+    case VK_FORMAT_R32G32_SINT:
+    case VK_FORMAT_R32G32_UINT:
+        return 8;
+    case VK_FORMAT_R32G32B32_SFLOAT:
+    case VK_FORMAT_R32G32B32_SINT:
+    case VK_FORMAT_R32G32B32_UINT:
+        return 12;
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+    case VK_FORMAT_R32G32B32A32_SINT:
+    case VK_FORMAT_R32G32B32A32_UINT:
+        return 16;
+    default:
+        return 0;
+    }
+}
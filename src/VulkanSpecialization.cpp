@@ -0,0 +1,51 @@
+#include "VulkanSpecialization.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+using namespace moo;
+
+void VulkanSpecialization::clear() {
+    m_entries.clear();
+    m_data.clear();
+}
+
+VkSpecializationInfo VulkanSpecialization::getInfo() const {
+    VkSpecializationInfo info {};
+    info.mapEntryCount = static_cast<uint32_t>(m_entries.size());
+    info.pMapEntries = m_entries.data();
+    info.dataSize = m_data.size();
+    info.pData = m_data.data();
+    return info;
+}
+
+void VulkanSpecialization::setBytes(uint32_t constantID, const void* value, size_t size) {
+    auto entry = std::lower_bound(m_entries.begin(), m_entries.end(), constantID,
+        [](const VkSpecializationMapEntry& e, uint32_t id) { return e.constantID < id; });
+
+    if (entry != m_entries.end() && entry->constantID == constantID && entry->size == size) {
+        std::memcpy(m_data.data() + entry->offset, value, size);
+        return;
+    }
+
+    // new constant or new type: repack, the data stays in constant ID order
+    if (entry != m_entries.end() && entry->constantID == constantID) {
+        m_data.erase(m_data.begin() + entry->offset, m_data.begin() + entry->offset + entry->size);
+        entry = m_entries.erase(entry);
+    }
+
+    uint32_t offset = 0;
+    if (entry != m_entries.begin()) {
+        offset = std::prev(entry)->offset + static_cast<uint32_t>(std::prev(entry)->size);
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    m_data.insert(m_data.begin() + offset, bytes, bytes + size);
+    entry = m_entries.insert(entry, VkSpecializationMapEntry{constantID, offset, size});
+
+    uint32_t next = offset;
+    for (; entry != m_entries.end(); ++entry) {
+        entry->offset = next;
+        next += static_cast<uint32_t>(entry->size);
+    }
+}
@@ -1,15 +1,16 @@
 #include "VulkanSwapchain.h"
 
 #include "vk_initializers.h"
+#include "MLogger.h"
 
 // std
+#include <algorithm>
 #include <array>
 //#include <cstdlib>
 //#include <cstring>
-#include <iostream>
-//#include <limits>
+#include <limits>
 //#include <set>
-//#include <stdexcept>
+#include <stdexcept>
 
 using namespace moo;
 
@@ -66,8 +67,12 @@ VulkanSwapchain::~VulkanSwapchain() {
 }
 
 VkResult VulkanSwapchain::acquireNextImage(uint32_t *imageIndex) {
-    vkWaitForFences(device.getDevice(), 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+    {
+        MFrameStats::ScopedTimer timer(m_frameStats, MFrameStats::Metric::WaitFence);
+        vkWaitForFences(device.getDevice(), 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+    }
 
+    MFrameStats::ScopedTimer timer(m_frameStats, MFrameStats::Metric::Acquire);
     VkResult result = vkAcquireNextImageKHR(device.getDevice(), m_swapchain, std::numeric_limits<uint64_t>::max(),
         imageAvailableSemaphores[currentFrame],  // must be a not signaled semaphore
         VK_NULL_HANDLE, imageIndex);
@@ -77,6 +82,7 @@ VkResult VulkanSwapchain::acquireNextImage(uint32_t *imageIndex) {
 
 VkResult VulkanSwapchain::submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex) {
     if(imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
+        MFrameStats::ScopedTimer timer(m_frameStats, MFrameStats::Metric::WaitFence);
         vkWaitForFences(device.getDevice(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
     }
     imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
@@ -114,7 +120,11 @@ VkResult VulkanSwapchain::submitCommandBuffers(const VkCommandBuffer *buffers, u
 
     presentInfo.pImageIndices = imageIndex;
 
-    VkResult result = vkQueuePresentKHR(device.getPresentQueue(), &presentInfo);
+    VkResult result;
+    {
+        MFrameStats::ScopedTimer timer(m_frameStats, MFrameStats::Metric::Present);
+        result = vkQueuePresentKHR(device.getPresentQueue(), &presentInfo);
+    }
 
     currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 
@@ -394,7 +404,7 @@ VkSurfaceFormatKHR VulkanSwapchain::chooseSwapSurfaceFormat(const std::vector<Vk
 VkPresentModeKHR VulkanSwapchain::chooseSwapPresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes) {
     for (const auto &availablePresentMode : availablePresentModes) {
         if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-            std::cout << "Present mode: Mailbox" << "\n";
+            MOO_LOG_INFO("Present mode: Mailbox");
             return availablePresentMode;
         }
     }
@@ -406,7 +416,7 @@ VkPresentModeKHR VulkanSwapchain::chooseSwapPresentMode(const std::vector<VkPres
   //   }
   // }
 
-    std::cout << "Present mode: V-Sync" << "\n";
+    MOO_LOG_INFO("Present mode: V-Sync");
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
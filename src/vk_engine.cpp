@@ -3,9 +3,9 @@
 #include <SDL_vulkan.h>
 #include "vk_initializers.h"
 #include "vk_pipeline.h"
+#include "MLogger.h"
 
 #include <iostream>
-#include <fstream>
 #include <set>
 #include <cassert>
 
@@ -60,7 +60,8 @@ QueueFamilyIndices VulkanEngine::findQueueFamilies(VkPhysicalDevice device, VkSu
 
     uint32_t i = 0;
     for (const auto& queueFamily : queueFamilies) {
-        if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        // compute dispatches are recorded with the draws, in the same command buffers
+        if ((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
             indices.graphicsFamily = i;
         }
 
@@ -175,39 +176,8 @@ bool VulkanEngine::checkDeviceExtensionSupport(VkPhysicalDevice device, std::vec
 }
 
 VkShaderModule VulkanEngine::loadShaderModuleFromFile(const std::string& filename) {
-    // open file, cursor at the end
-    std::ifstream file(filename, std::ios::binary | std::ios::ate);
-
-    if(!file.is_open())
-        throw std::runtime_error("Failed to open file: " + filename);
-
-    std::streampos filesize = file.tellg();
-    //size_t filesize = (size_t)file.tellg();
-
-    // spirv expects the buffer to be an uint32 instead of a char,
-    // reserve an int vector big enough for the entire file ELEMENTS
-    //std::vector<uint32_t> buffer(filesize / sizeof(uint32_t)); // bytes -> uint32
-    // std::vector<char> buffer(fileSize); equals to 
-    std::vector<char> buffer(filesize / sizeof(char));
-    file.seekg(0, std::ios::beg); // file cursor at the beginning, rdy to read 
-    file.read(buffer.data(), filesize);
-    //file.read((char*)buffer.data(), filesize);
-    file.close();
-
-    VkShaderModuleCreateInfo createInfo {};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = buffer.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(buffer.data());
-
-    // check creation went well, 
-    // cause there are often error VK_CHECK isn't suitable
-    VkShaderModule shaderModule;
-    if(vkCreateShaderModule(m_device, &createInfo, nullptr, &shaderModule)
-        != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create shader module for: " + filename);
-    }
-    return shaderModule;
+    // mapped and compiled once, owned by the shader cache: pipeline rebuilds reuse the module
+    return m_shaderCache->getModule(filename);
 }
 
 SwapChainSupportDetails VulkanEngine::querySwapChainSupport(VkPhysicalDevice device) {
@@ -280,6 +250,14 @@ void VulkanEngine::init() {
 
 	// logical device
     createLogicalDevice(m_gpu);
+    m_pipelineCache = std::make_unique<moo::VulkanPipelineCache>(m_device, m_deviceProperties, PIPELINE_CACHE_FILE);
+    m_shaderCache = std::make_unique<moo::VulkanShaderCache>(m_device, false);
+    m_layoutCache = std::make_unique<moo::VulkanLayoutCache>(m_device);
+    m_descriptors = std::make_unique<moo::VulkanDescriptorAllocator>(m_device, *m_layoutCache, MAX_FRAMES_IN_FLIGHT);
+    if (m_bindlessCapacity.textures > 0 && m_bindlessCapacity.buffers > 0) {
+        m_bindless = std::make_unique<moo::VulkanBindlessTable>(m_device, m_bindlessCapacity, MAX_FRAMES_IN_FLIGHT);
+    }
+    m_pipelineRegistry = std::make_unique<moo::VulkanPipelineRegistry>(m_device, m_pipelineCache->getCache());
 
     // swapchain
     createSwapchain();
@@ -315,6 +293,12 @@ void VulkanEngine::cleanup() {
         cleanupSwapChain();
 
         vmaDestroyAllocator(m_allocator);
+        m_pipelineRegistry.reset();
+        m_descriptors.reset();
+        m_bindless.reset();
+        m_layoutCache.reset();
+        m_shaderCache.reset();
+        m_pipelineCache.reset(); // saved to disk on destruction
         vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
         vkDestroyDevice(m_device, nullptr);
         
@@ -331,8 +315,7 @@ void VulkanEngine::cleanupSwapChain() {
         vkDestroyFramebuffer(m_device, framebuffers, nullptr);
     }
 
-    vkDestroyPipeline(m_device, m_defaultGraphicsPipeline, nullptr);
-    vkDestroyPipelineLayout(m_device, m_defaultPipeLayout, nullptr);
+    m_pipelineRegistry->release(m_defaultGraphicsPipeline);
     vkDestroyRenderPass(m_device, m_renderPass, nullptr);
 
     freeImageViews();
@@ -351,8 +334,8 @@ void VulkanEngine::reCreateSwapchain() {
         vkDestroyFramebuffer(m_device, framebuffers, nullptr);
     }
 
-    vkDestroyPipeline(m_device, m_defaultGraphicsPipeline, nullptr);
-    vkDestroyPipelineLayout(m_device, m_defaultPipeLayout, nullptr);
+    // released once the new one is acquired: same format, same registry entry, no recompile
+    VkPipeline oldPipeline = m_defaultGraphicsPipeline;
     vkDestroyRenderPass(m_device, m_renderPass, nullptr);
 
     freeImageViews();
@@ -364,6 +347,7 @@ void VulkanEngine::reCreateSwapchain() {
     createImageViews();
     init_default_renderpass();
     init_pipelines();
+    m_pipelineRegistry->release(oldPipeline);
     init_framebuffers();
 
     /*if (m_swapchainImages.size() != m_frames.size()) {
@@ -375,22 +359,35 @@ void VulkanEngine::reCreateSwapchain() {
         createCommandBuffer();
     }*/ 
 
-    std::cout << "width: " << m_window.getExtent().width << "; height: " << m_window.getExtent().height << "\n";
+    MOO_LOG_DEBUG("width: %u; height: %u", m_window.getExtent().width, m_window.getExtent().height);
 }
 
 void VulkanEngine::drawFrame() {
 // 1st: waiting for the previous frame
     // CPU waits until GPU has finished rendering last frame, timeout 1 sec
-    VK_CHECK(vkWaitForFences(m_device, 1, &get_current_frame().m_inFlightFence, VK_TRUE, 1000000000ULL)); // 1 sec in nanoseconds 10^9; UINT64_MAX disables the timeout
+    {
+        moo::MFrameStats::ScopedTimer timer(&m_frameStats, moo::MFrameStats::Metric::WaitFence);
+        VK_CHECK(vkWaitForFences(m_device, 1, &get_current_frame().m_inFlightFence, VK_TRUE, 1000000000ULL)); // 1 sec in nanoseconds 10^9; UINT64_MAX disables the timeout
+    }
+    // the frame's previous sets are no longer in use
+    m_descriptors->beginFrame(m_frameNumber % MAX_FRAMES_IN_FLIGHT);
+    if (m_bindless) {
+        m_bindless->beginFrame();
+    }
 
 // 2nd: acquiring an image from the swap chain
     // request img from swapchain, 1 sec timeout
     uint32_t swapchain_imageIndex;
     // obj to be signaled when presentation engine finished using the image
-    VkResult result = vkAcquireNextImageKHR(m_device, m_swapchain, 1000000000ULL, get_current_frame().m_imageAvailableSemaphore, nullptr, &swapchain_imageIndex); 
+    VkResult result;
+    {
+        moo::MFrameStats::ScopedTimer timer(&m_frameStats, moo::MFrameStats::Metric::Acquire);
+        result = vkAcquireNextImageKHR(m_device, m_swapchain, 1000000000ULL, get_current_frame().m_imageAvailableSemaphore, nullptr, &swapchain_imageIndex); 
+    }
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         reCreateSwapchain();
-        std::cout << "First check\n";
+        m_window.requestRedraw();
+        MOO_LOG_DEBUG("First check");
         return;
     } else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         throw std::runtime_error("Failed to acquire swapchain image");
@@ -448,12 +445,16 @@ void VulkanEngine::drawFrame() {
     present_info.pSwapchains = swapchains.data();
     present_info.pImageIndices = &swapchain_imageIndex;
     
-    result = vkQueuePresentKHR(m_graphicsQueue, &present_info);
+    {
+        moo::MFrameStats::ScopedTimer timer(&m_frameStats, moo::MFrameStats::Metric::Present);
+        result = vkQueuePresentKHR(m_graphicsQueue, &present_info);
+    }
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_window.wasWindowResized()) {
         m_window.resetWindowResizedFlag();
         reCreateSwapchain();
+        m_window.requestRedraw();
         //return;
-        std::cout << "Second check\n";
+        MOO_LOG_DEBUG("Second check");
     } else if (result != VK_SUCCESS) {
         throw std::runtime_error("Failed to present swapchain image.");
     }
@@ -462,19 +463,21 @@ void VulkanEngine::drawFrame() {
 }
 
 void VulkanEngine::run() {
-	SDL_Event e;
-
 	//main loop
 	while (!m_window.isClosing())
 	{
-		//Handle events on queue
-		while (SDL_PollEvent(&e) != 0)
-		{
-            m_window.handleEvent(e);            
-		}
+		//Handle events on queue, blocking while there is nothing to draw
+        bool idle = m_window.isMinimized() || !m_window.needsRedraw();
+        m_window.processEvents(idle, IDLE_WAIT_TIMEOUT_MS);
         
-        if(!m_window.isMinimized()) {
+        if(!m_window.isMinimized() && m_window.needsRedraw()) {
+            m_window.resetRedrawRequest();
+            m_frameStats.beginFrame();
 		    drawFrame();
+            if (m_frameStats.endFrame()) {
+                m_window.setTitleOverlay(m_frameStats.getSummary());
+            }
+            m_pipelineCache->saveIfDue();
         }
 	}
 }
@@ -617,6 +620,16 @@ void VulkanEngine::createLogicalDevice(VkPhysicalDevice& gpu) {
     deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
     deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
 
+    // descriptor indexing, only chained when the GPU has all of it
+    VkPhysicalDeviceVulkan12Features vulkan12Features {};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    if constexpr (BINDLESS) {
+        m_bindlessCapacity = moo::VulkanBindlessTable::enableFeatures(gpu, vulkan12Features);
+        if (m_bindlessCapacity.textures > 0 && m_bindlessCapacity.buffers > 0) {
+            deviceCreateInfo.pNext = &vulkan12Features;
+        }
+    }
+
     // extensions
     deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(m_deviceExtensions.size());
     deviceCreateInfo.ppEnabledExtensionNames = m_deviceExtensions.data();
@@ -802,9 +815,20 @@ void VulkanEngine::recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t i
     //           V
 
     //draw_objects(cmd, _renderables.data(), static_cast<uint32_t>(_renderables.size()));
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_defaultGraphicsPipeline);
+    m_encoder.begin(commandBuffer);
+    if (m_bindless) {
+        m_bindless->bind(m_encoder, VK_PIPELINE_BIND_POINT_GRAPHICS, m_defaultPipeLayout);
+    }
+    m_encoder.bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, m_defaultGraphicsPipeline);
+    if (m_extendedDynamicState) {
+        m_encoder.getDynamicState().apply(moo::VulkanDynamicState::State{});
+    }
 
-    triangle0.bind(commandBuffer);
+    MeshPushConstants constants {};
+    constants.render_matrix = glm::mat4{1.0f};
+    m_encoder.push<MeshPushBlock>(m_defaultPipeLayout, constants);
+
+    triangle0.bind(m_encoder);
     triangle0.draw(commandBuffer);
 
     //           ^
@@ -1043,7 +1067,12 @@ void VulkanEngine::init_pipelines() {
     pipelineBuilder.colorBlendAttachment = vkinit::colorblendAttachmentState();
     
     // dynamic state
-    std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    std::vector<VkDynamicState> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    // Vulkan 1.3: cull mode, front face, topology and depth state too, one pipeline for every combination
+    m_extendedDynamicState = moo::VulkanDynamicState::isSupported(m_deviceProperties);
+    if (m_extendedDynamicState) {
+        moo::VulkanDynamicState::addDynamicStates(dynamicStates);
+    }
 
     VkPipelineDynamicStateCreateInfo dynamicStateInfo {};
     dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
@@ -1054,24 +1083,29 @@ void VulkanEngine::init_pipelines() {
 
     // vertex input description
     VertexInputDescription vertexDescription = Vertex::getVertexInputDescription();
+    const moo::VulkanShaderReflection& vertReflection = m_shaderCache->getReflection("./../shaders/shader.vert.spv");
+    assert(vertReflection.matchesVertexAttributes(vertexDescription.attributes) && "Vertex doesn't match the vertex shader inputs.");
     pipelineBuilder.vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexDescription.bindings.size());
     pipelineBuilder.vertexInputInfo.pVertexBindingDescriptions = vertexDescription.bindings.data();
     pipelineBuilder.vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexDescription.attributes.size());
     pipelineBuilder.vertexInputInfo.pVertexAttributeDescriptions = vertexDescription.attributes.data();
     
-    // Pipeline layout
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo = vkinit::pipelineLayoutCreateInfo();
-        
-    VK_CHECK(vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_defaultPipeLayout));
+    // Pipeline layout: reflected from the shaders, the cache hands back the same one after a resize;
+    // with bindless resources the table's set, runtime arrays aren't reflected
+    if (m_bindless) {
+        m_defaultPipeLayout = m_layoutCache->getPipelineLayout({m_bindless->getSetLayout()}, MeshPushBlock::range());
+    } else {
+        m_defaultPipeLayout = m_layoutCache->getLayout({&vertReflection, &m_shaderCache->getReflection("./../shaders/shader.frag.spv")},
+            MeshPushBlock::range()).pipelineLayout;
+    }
 
     pipelineBuilder.pipelineLayout = m_defaultPipeLayout;
 // pipeline end
 
 // create pipeline
-    m_defaultGraphicsPipeline = pipelineBuilder.build_pipeline(m_device, m_renderPass);
-
-    vkDestroyShaderModule(m_device, vertShaderModule, nullptr);
-    vkDestroyShaderModule(m_device, fragShaderModule, nullptr);
+    moo::VulkanPipelineRegistry::AttachmentFormats attachmentFormats {};
+    attachmentFormats.color = {m_swapchainImageFormat};
+    m_defaultGraphicsPipeline = pipelineBuilder.build_pipeline(*m_pipelineRegistry, m_renderPass, &attachmentFormats);
 }
 
 void VulkanEngine::init_framebuffers() {
@@ -1,6 +1,6 @@
 ﻿#include <vk_initializers.h>
 
-VkPipelineShaderStageCreateInfo vkinit::pipelineShaderStageCreateInfo(VkShaderStageFlagBits stage, VkShaderModule shaderModule) {
+VkPipelineShaderStageCreateInfo vkinit::pipelineShaderStageCreateInfo(VkShaderStageFlagBits stage, VkShaderModule shaderModule, const VkSpecializationInfo* specializationInfo) {
     VkPipelineShaderStageCreateInfo info {};
 	info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	info.pNext = nullptr;
@@ -8,7 +8,7 @@ VkPipelineShaderStageCreateInfo vkinit::pipelineShaderStageCreateInfo(VkShaderSt
 	info.module = shaderModule; // module containing code for this shader stage
 	info.pName = "main"; // entry point of the shader, can be any funcion name: using "main" cause reflects the naming in the shaders written so far
 	info.flags = 0;
-	info.pSpecializationInfo = nullptr;
+	info.pSpecializationInfo = specializationInfo; // constant_id values folded by the driver, may be null
 
     return info;
 }
@@ -258,4 +258,57 @@ VkPresentInfoKHR vkinit::presentInfo() {
 	info.pResults = nullptr; // Optional
 
 	return info;
+}
+
+VkComputePipelineCreateInfo vkinit::computePipelineCreateInfo(const VkPipelineShaderStageCreateInfo& stage, VkPipelineLayout layout) {
+	VkComputePipelineCreateInfo info {};
+	info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	info.pNext = nullptr;
+	info.stage = stage; // a single compute stage, no fixed-function state
+	info.layout = layout;
+	info.basePipelineHandle = VK_NULL_HANDLE; // Optional
+	info.basePipelineIndex = -1; // Optional
+
+	return info;
+}
+
+VkDescriptorSetLayoutBinding vkinit::descriptorSetLayoutBinding(VkDescriptorType type, VkShaderStageFlags stageFlags, uint32_t binding) {
+	VkDescriptorSetLayoutBinding setBinding {};
+	setBinding.binding = binding;
+	setBinding.descriptorCount = 1;
+	setBinding.descriptorType = type;
+	setBinding.pImmutableSamplers = nullptr;
+	setBinding.stageFlags = stageFlags;
+
+	return setBinding;
+}
+
+VkWriteDescriptorSet vkinit::writeDescriptorBuffer(VkDescriptorType type, VkDescriptorSet dstSet, const VkDescriptorBufferInfo* bufferInfo, uint32_t binding) {
+	VkWriteDescriptorSet write {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.pNext = nullptr;
+
+	write.dstBinding = binding;
+	write.dstSet = dstSet;
+	write.descriptorCount = 1;
+	write.descriptorType = type;
+	write.pBufferInfo = bufferInfo;
+
+	return write;
+}
+
+VkBufferMemoryBarrier vkinit::bufferMemoryBarrier(VkBuffer buffer, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask, VkDeviceSize offset, VkDeviceSize size) {
+	VkBufferMemoryBarrier barrier {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.pNext = nullptr;
+	barrier.srcAccessMask = srcAccessMask;
+	barrier.dstAccessMask = dstAccessMask;
+	// same queue on both sides, no ownership transfer
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = buffer;
+	barrier.offset = offset;
+	barrier.size = size;
+
+	return barrier;
 }
\ No newline at end of file
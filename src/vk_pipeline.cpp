@@ -5,9 +5,21 @@
 
 using namespace mii;
 
-VkPipeline PipelineBuilder::build_pipeline(VkDevice device, VkRenderPass renderpass) {
+VkGraphicsPipelineCreateInfo PipelineBuilder::fill_create_info(VkRenderPass renderpass, CreateState& state) const {
+    // specialization constants: reserved up front, the stages point into the vector
+    state.stages = shaderStages;
+    state.specializationInfos.reserve(state.stages.size());
+    for (VkPipelineShaderStageCreateInfo& stage : state.stages) {
+        auto specialization = specializations.find(stage.stage);
+        if (specialization != specializations.end() && !specialization->second.empty()) {
+            state.specializationInfos.push_back(specialization->second.getInfo());
+            stage.pSpecializationInfo = &state.specializationInfos.back();
+        }
+    }
+
     // color blending global configuration
-    VkPipelineColorBlendStateCreateInfo colorBlending {};
+    VkPipelineColorBlendStateCreateInfo& colorBlending = state.colorBlending;
+    colorBlending = {};
     colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
     colorBlending.logicOpEnable = VK_FALSE;
     colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
@@ -23,8 +35,8 @@ VkPipeline PipelineBuilder::build_pipeline(VkDevice device, VkRenderPass renderp
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineInfo.pNext = nullptr;
 // Shader stages: the shader modules that define the functionality of the programmable stages of the graphics pipeline
-    pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
-    pipelineInfo.pStages = shaderStages.data();
+    pipelineInfo.stageCount = static_cast<uint32_t>(state.stages.size());
+    pipelineInfo.pStages = state.stages.data();
 
 // Fixed-function state: all of the structures that define the fixed-function stages of the pipeline, like input assembly, rasterizer, viewport and color blending
     pipelineInfo.pVertexInputState = &vertexInputInfo;
@@ -45,11 +57,27 @@ VkPipeline PipelineBuilder::build_pipeline(VkDevice device, VkRenderPass renderp
     
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
     pipelineInfo.basePipelineIndex = -1; // Optional
+
+    return pipelineInfo;
+}
+
+VkPipeline PipelineBuilder::build_pipeline(VkDevice device, VkRenderPass renderpass, VkPipelineCache cache) const {
+    CreateState state;
+    VkGraphicsPipelineCreateInfo pipelineInfo = fill_create_info(renderpass, state);
     
     VkPipeline pipeline;
-    if(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+    if(vkCreateGraphicsPipelines(device, cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create graphics pipeline."); // failed to create graphics pipeline
     }
 
     return pipeline;
+}
+
+VkPipeline PipelineBuilder::build_pipeline(moo::VulkanPipelineRegistry& registry, VkRenderPass renderpass,
+    const moo::VulkanPipelineRegistry::AttachmentFormats* formats) const
+{
+    CreateState state;
+    VkGraphicsPipelineCreateInfo pipelineInfo = fill_create_info(renderpass, state);
+
+    return registry.acquire(pipelineInfo, formats);
 }
\ No newline at end of file